@@ -0,0 +1,38 @@
+#ifndef WF_BENCHMARKS_BENCH_HPP
+#define WF_BENCHMARKS_BENCH_HPP
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+/**
+ * A minimal helper for the benchmarks: runs a function a number of times and
+ * prints the average time per call.
+ */
+namespace bench
+{
+template<class T>
+inline void do_not_optimize(const T& value)
+{
+    asm volatile ("" : : "g" (&value) : "memory");
+}
+
+template<class Function>
+inline double run(const std::string& name, int iterations, Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+    {
+        function();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() /
+        iterations;
+    std::printf("%-48s %12.1f ns/iter\n", name.c_str(), ns);
+
+    return ns;
+}
+}
+
+#endif /* end of include guard: WF_BENCHMARKS_BENCH_HPP */
@@ -0,0 +1,179 @@
+/*
+ * Restacking and enumerating 500 views, with the views in single-view
+ * floating sublayers as in the workspace layer.
+ *
+ * Compares the stack_list_t based layers with the previous layout, where
+ * sublayers and views were kept in std::lists and looked up by linear
+ * search.
+ */
+#include "bench.hpp"
+#include "../src/output/stack-list.hpp"
+#include <wayfire/nonstd/observer_ptr.h>
+#include <list>
+#include <memory>
+#include <random>
+
+struct fake_view_t
+{
+    int id;
+};
+
+using fake_view = nonstd::observer_ptr<fake_view_t>;
+
+static constexpr int NUM_VIEWS = 500;
+
+namespace flat
+{
+struct sublayer_t
+{
+    wf::stack_list_t<fake_view> views;
+    size_t stack_position = -1;
+};
+
+struct layer_t
+{
+    wf::stack_list_t<std::unique_ptr<sublayer_t>,
+        wf::intrusive_stack_positions_t<sublayer_t*>> floating;
+    std::unordered_map<fake_view_t*, sublayer_t*> view_sublayer;
+
+    void add(fake_view view)
+    {
+        auto sublayer = std::make_unique<sublayer_t>();
+        sublayer->views.push_front(view);
+        view_sublayer[view.get()] = sublayer.get();
+        floating.push_front(std::move(sublayer));
+    }
+
+    void bring_to_front(fake_view view)
+    {
+        auto sublayer = view_sublayer[view.get()];
+        floating.raise_to_front(sublayer);
+        sublayer->views.raise_to_front(view.get());
+    }
+
+    void restack_above(fake_view view, fake_view below)
+    {
+        floating.move_above(view_sublayer[view.get()],
+            view_sublayer[below.get()]);
+    }
+
+    template<class F>
+    void for_each(F f)
+    {
+        for (auto& sublayer : floating)
+        {
+            for (auto& view : sublayer->views)
+            {
+                f(view);
+            }
+        }
+    }
+};
+}
+
+namespace linked
+{
+template<class T, class Needle>
+typename std::list<T>::iterator find_in(std::list<T>& hay, const Needle& needle)
+{
+    return std::find_if(hay.begin(), hay.end(),
+        [&] (const T& elem) { return elem.get() == needle; });
+}
+
+struct sublayer_t
+{
+    std::list<fake_view> views;
+};
+
+struct layer_t
+{
+    std::list<std::unique_ptr<sublayer_t>> floating;
+    std::unordered_map<fake_view_t*, sublayer_t*> view_sublayer;
+
+    void add(fake_view view)
+    {
+        auto sublayer = std::make_unique<sublayer_t>();
+        sublayer->views.push_front(view);
+        view_sublayer[view.get()] = sublayer.get();
+        floating.push_front(std::move(sublayer));
+    }
+
+    void bring_to_front(fake_view view)
+    {
+        auto sublayer = view_sublayer[view.get()];
+        floating.splice(floating.begin(), floating, find_in(floating, sublayer));
+        sublayer->views.splice(sublayer->views.begin(), sublayer->views,
+            find_in(sublayer->views, view.get()));
+    }
+
+    void restack_above(fake_view view, fake_view below)
+    {
+        auto it  = find_in(floating, view_sublayer[view.get()]);
+        auto pos = find_in(floating, view_sublayer[below.get()]);
+        floating.splice(pos, floating, it);
+    }
+
+    template<class F>
+    void for_each(F f)
+    {
+        for (auto& sublayer : floating)
+        {
+            for (auto& view : sublayer->views)
+            {
+                f(view);
+            }
+        }
+    }
+};
+}
+
+template<class Layer>
+static void run(const char *name, std::vector<fake_view_t>& storage)
+{
+    Layer layer;
+    std::vector<fake_view> views;
+    for (auto& v : storage)
+    {
+        views.push_back(fake_view{&v});
+        layer.add(views.back());
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> pick(0, NUM_VIEWS - 1);
+
+    std::string prefix = name;
+    bench::run(prefix + " bring_to_front", 100000, [&] ()
+    {
+        layer.bring_to_front(views[pick(rng)]);
+    });
+
+    bench::run(prefix + " restack_above", 100000, [&] ()
+    {
+        int a = pick(rng), b = pick(rng);
+        if (a != b)
+        {
+            layer.restack_above(views[a], views[b]);
+        }
+    });
+
+    int64_t sum = 0;
+    bench::run(prefix + " enumerate", 10000, [&] ()
+    {
+        layer.for_each([&] (fake_view view) { sum += view->id; });
+    });
+    bench::do_not_optimize(sum);
+}
+
+int main()
+{
+    std::vector<fake_view_t> storage(NUM_VIEWS);
+    for (int i = 0; i < NUM_VIEWS; i++)
+    {
+        storage[i].id = i;
+    }
+
+    run<flat::layer_t>("stack_list", storage);
+    run<linked::layer_t>("std::list", storage);
+
+    return 0;
+}
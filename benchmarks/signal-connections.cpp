@@ -0,0 +1,144 @@
+/*
+ * Connecting and disconnecting thousands of listeners to a single signal,
+ * in random order, and emitting the signal in between. Also connecting a
+ * single listener to thousands of providers.
+ */
+#include "bench.hpp"
+#include <wayfire/object.hpp>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static constexpr int NUM_LISTENERS = 5000;
+static constexpr int NUM_PROVIDERS = 5000;
+
+struct provider_t : public wf::object_base_t
+{};
+
+int main()
+{
+    provider_t provider;
+    static const wf::signal_id_t signal{"stress"};
+
+    int64_t calls = 0;
+    std::vector<std::unique_ptr<wf::signal_connection_t>> connections;
+    for (int i = 0; i < NUM_LISTENERS; i++)
+    {
+        connections.push_back(std::make_unique<wf::signal_connection_t>(
+            [&] (wf::signal_data_t*) { ++calls; }));
+    }
+
+    std::vector<int> order(NUM_LISTENERS);
+    for (int i = 0; i < NUM_LISTENERS; i++)
+    {
+        order[i] = i;
+    }
+
+    std::mt19937 rng(42);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    bench::run("connect + disconnect 5000 (random order)", 200, [&] ()
+    {
+        for (auto& connection : connections)
+        {
+            provider.connect_signal(signal, connection.get());
+        }
+
+        for (int i : order)
+        {
+            connections[i]->disconnect();
+        }
+    });
+
+    bench::run("connect + disconnect 5000 (emit in between)", 200, [&] ()
+    {
+        for (auto& connection : connections)
+        {
+            provider.connect_signal(signal, connection.get());
+        }
+
+        for (int i = 0; i < NUM_LISTENERS; i++)
+        {
+            connections[order[i]]->disconnect();
+            if (i % 500 == 0)
+            {
+                provider.emit_signal(signal, nullptr);
+            }
+        }
+    });
+
+    /* Disconnect from within the callbacks while emitting */
+    std::vector<std::unique_ptr<wf::signal_connection_t>> self_removing;
+    for (int i = 0; i < NUM_LISTENERS; i++)
+    {
+        self_removing.push_back(std::make_unique<wf::signal_connection_t>());
+        auto connection = self_removing.back().get();
+        connection->set_callback([connection, &calls] (wf::signal_data_t*)
+        {
+            ++calls;
+            connection->disconnect();
+        });
+    }
+
+    bench::run("disconnect 5000 during emit", 200, [&] ()
+    {
+        for (auto& connection : self_removing)
+        {
+            provider.connect_signal(signal, connection.get());
+        }
+
+        provider.emit_signal(signal, nullptr);
+    });
+
+    /* One connection shared by many providers */
+    std::vector<std::unique_ptr<provider_t>> providers;
+    for (int i = 0; i < NUM_PROVIDERS; i++)
+    {
+        providers.push_back(std::make_unique<provider_t>());
+    }
+
+    wf::signal_connection_t shared{[&] (wf::signal_data_t*) { ++calls; }};
+    bench::run("shared connection: connect 5000 providers + disconnect", 200,
+        [&] ()
+    {
+        for (auto& p : providers)
+        {
+            p->connect_signal(signal, &shared);
+        }
+
+        shared.disconnect();
+    });
+
+    bench::run("shared connection: disconnect from 5000 providers one by one",
+        200, [&] ()
+    {
+        for (auto& p : providers)
+        {
+            p->connect_signal(signal, &shared);
+        }
+
+        for (int i : order)
+        {
+            providers[i]->disconnect_signal(&shared);
+        }
+    });
+
+    bench::run("shared connection: destroy 5000 providers", 20, [&] ()
+    {
+        std::vector<std::unique_ptr<provider_t>> temporary;
+        for (int i = 0; i < NUM_PROVIDERS; i++)
+        {
+            temporary.push_back(std::make_unique<provider_t>());
+            temporary.back()->connect_signal(signal, &shared);
+        }
+
+        for (int i : order)
+        {
+            temporary[i].reset();
+        }
+    });
+
+    bench::do_not_optimize(calls);
+
+    return 0;
+}
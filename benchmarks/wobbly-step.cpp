@@ -0,0 +1,91 @@
+/*
+ * Stepping the spring models of 100 wobbly windows, which are dragged
+ * around so that they never settle.
+ *
+ * Run with the default 4x4 grid and with the largest grid, at 60 fps and at
+ * 15 fps, where each frame runs several simulation steps.
+ */
+#include "bench.hpp"
+#include <cmath>
+#include <vector>
+
+extern "C"
+{
+#include "../plugins/wobbly/wobbly.h"
+}
+
+static constexpr int NUM_MODELS = 100;
+static int max_grid = WOBBLY_MIN_GRID;
+
+extern "C"
+{
+double wobbly_settings_get_friction()
+{
+    return 3.0;
+}
+
+double wobbly_settings_get_spring_k()
+{
+    return 8.0;
+}
+
+int wobbly_settings_get_max_grid()
+{
+    return max_grid;
+}
+}
+
+static void run(const std::string& name, int grid, int frame_time)
+{
+    max_grid = grid;
+
+    std::vector<wobbly_surface> surfaces(NUM_MODELS);
+    std::vector<wobbly_surface*> batch;
+    std::vector<int> times(NUM_MODELS, frame_time);
+    for (int i = 0; i < NUM_MODELS; i++)
+    {
+        auto& surface = surfaces[i];
+        surface = {};
+        surface.x      = 10 * i;
+        surface.y      = 5 * i;
+        surface.width  = 1920;
+        surface.height = 1080;
+        wobbly_init(&surface);
+        wobbly_grab_notify(&surface, surface.x + 100, surface.y + 10);
+        batch.push_back(&surface);
+    }
+
+    int frame = 0;
+    bench::run(name, 2000, [&] ()
+    {
+        ++frame;
+        for (int i = 0; i < NUM_MODELS; i++)
+        {
+            wobbly_move_notify(batch[i],
+                surfaces[i].x + 100 + 50 * std::sin(frame * 0.1 + i),
+                surfaces[i].y + 10);
+        }
+
+        wobbly_prepare_paint_batch(batch.data(), times.data(), NUM_MODELS);
+        for (auto surface : batch)
+        {
+            wobbly_done_paint(surface);
+        }
+    });
+
+    for (auto& surface : surfaces)
+    {
+        wobbly_fini(&surface);
+    }
+}
+
+int main()
+{
+    run("step 100 models, 4x4 grid", WOBBLY_MIN_GRID, 16);
+    run("step 100 models, 1920x1080 at the max grid", WOBBLY_MAX_GRID, 16);
+    run("step 100 models, 4x4 grid, 15 fps", WOBBLY_MIN_GRID, 66);
+    run("step 100 models, 1920x1080 at the max grid, 15 fps",
+        WOBBLY_MAX_GRID, 66);
+
+    return 0;
+}
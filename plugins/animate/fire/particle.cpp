@@ -1,43 +1,12 @@
 #include "particle.hpp"
 #include "shaders.hpp"
 #include <wayfire/core.hpp>
-#include <thread>
+#include <wayfire/task-pool.hpp>
+#include <cmath>
+#include <algorithm>
 
-void Particle::update(float time)
-{
-    if (life <= 0) // ignore
-    {
-        return;
-    }
-
-    const float slowdown = 0.8;
-
-    pos   += speed * 0.2f * slowdown;
-    speed += g * 0.3f * slowdown;
-
-    if (life != 0)
-    {
-        color.a /= life;
-    }
-
-    life    -= fade * 0.3 * slowdown;
-    radius   = base_radius * std::pow(life, 0.5);
-    color.a *= life;
-
-    if (start_pos.x < pos.x)
-    {
-        g.x = -1;
-    } else
-    {
-        g.x = 1;
-    }
-
-    if (life <= 0)
-    {
-        /* move outside */
-        pos = {-10000, -10000};
-    }
-}
+/* Minimal number of particles updated in one task */
+static constexpr int MIN_PARTICLES_PER_TASK = 512;
 
 ParticleSystem::ParticleSystem(int particles, ParticleIniter init_func)
 {
@@ -57,15 +26,40 @@ ParticleSystem::~ParticleSystem()
     OpenGL::render_end();
 }
 
+void ParticleSystem::store_particle(int i, const Particle& p)
+{
+    life[i] = p.life;
+    fade[i] = p.fade;
+    base_radius[i] = p.base_radius;
+    radius[i] = p.radius;
+
+    center[2 * i]     = p.pos.x;
+    center[2 * i + 1] = p.pos.y;
+    speed_x[i] = p.speed.x;
+    speed_y[i] = p.speed.y;
+    g_x[i]     = p.g.x;
+    g_y[i]     = p.g.y;
+    start_x[i] = p.start_pos.x;
+
+    for (int j = 0; j < 4; j++)
+    {
+        color[4 * i + j] = p.color[j];
+        dark_color[4 * i + j] = p.color[j] * 0.5;
+    }
+}
+
 int ParticleSystem::spawn(int num)
 {
     // TODO: multithread this
     int spawned = 0;
-    for (size_t i = 0; i < ps.size() && spawned < num; i++)
+    for (int i = 0; i < size() && spawned < num; i++)
     {
-        if (ps[i].life <= 0)
+        if (life[i] <= 0)
         {
-            pinit_func(ps[i]);
+            Particle p;
+            pinit_func(p);
+            store_particle(i, p);
+
             ++spawned;
             ++particles_alive;
         }
@@ -76,21 +70,27 @@ int ParticleSystem::spawn(int num)
 
 void ParticleSystem::resize(int num)
 {
-    if (num == (int)ps.size())
+    if (num == size())
     {
         return;
     }
 
-    // TODO: multithread this
-    for (int i = num; i < (int)ps.size(); i++)
+    for (int i = num; i < size(); i++)
     {
-        if (ps[i].life >= 0)
+        if (life[i] > 0)
         {
             --particles_alive;
         }
     }
 
-    ps.resize(num);
+    life.resize(num, -1);
+    fade.resize(num);
+    base_radius.resize(num);
+    speed_x.resize(num);
+    speed_y.resize(num);
+    g_x.resize(num);
+    g_y.resize(num);
+    start_x.resize(num);
 
     color.resize(color_per_particle * num);
     dark_color.resize(color_per_particle * num);
@@ -100,62 +100,56 @@ void ParticleSystem::resize(int num)
 
 int ParticleSystem::size()
 {
-    return ps.size();
+    return life.size();
 }
 
+/* time is the percentage of the frame which has elapsed */
 void ParticleSystem::update_worker(float time, int start, int end)
 {
-    end = std::min(end, (int)ps.size());
+    const float slowdown = 0.8;
+
+    /* The loop does not branch on whether a particle is alive. Instead, the
+     * new state is computed for all particles and only kept for the living
+     * ones, so that the compiler can vectorize it. */
+    int died = 0;
     for (int i = start; i < end; ++i)
     {
-        if (ps[i].life <= 0)
-        {
-            continue;
-        }
-
-        // printf("%d\n", i);
-        ps[i].update(time);
-
-        if (ps[i].life <= 0)
-        {
-            --particles_alive;
-        }
-
-        for (int j = 0; j < 4; j++) // maybe use memcpy?
-        {
-            color[4 * i + j] = ps[i].color[j];
-            dark_color[4 * i + j] = ps[i].color[j] * 0.5;
-        }
-
-        // printf("center %d gets %f", 2 * i, ps[i].pos[0]);
-        center[2 * i]     = ps[i].pos[0];
-        center[2 * i + 1] = ps[i].pos[1];
-
-        radius[i] = ps[i].radius;
+        bool alive = life[i] > 0;
+
+        float x = center[2 * i] + speed_x[i] * 0.2f * slowdown;
+        float y = center[2 * i + 1] + speed_y[i] * 0.2f * slowdown;
+        float vx = speed_x[i] + g_x[i] * 0.3f * slowdown;
+        float vy = speed_y[i] + g_y[i] * 0.3f * slowdown;
+
+        float l = life[i] - fade[i] * 0.3f * slowdown;
+        float a = color[4 * i + 3] / (alive ? life[i] : 1.0f) * l;
+        float r = base_radius[i] * std::sqrt(std::max(l, 0.0f));
+        float gx = (start_x[i] < x) ? -1.0f : 1.0f;
+
+        bool dies = alive && (l <= 0);
+        died += dies;
+
+        /* move dead particles outside */
+        x = dies ? -10000.0f : x;
+        y = dies ? -10000.0f : y;
+
+        center[2 * i]     = alive ? x : center[2 * i];
+        center[2 * i + 1] = alive ? y : center[2 * i + 1];
+        speed_x[i] = alive ? vx : speed_x[i];
+        speed_y[i] = alive ? vy : speed_y[i];
+        g_x[i]     = alive ? gx : g_x[i];
+        life[i]    = alive ? l : life[i];
+        radius[i]  = alive ? r : radius[i];
+        color[4 * i + 3] = alive ? a : color[4 * i + 3];
     }
-}
 
-void ParticleSystem::exec_worker_threads(std::function<void(int, int)> spawn_worker)
-{
-// return spawn_worker(0, ps.size());
-
-    const int num_threads = std::thread::hardware_concurrency();
-    const int worker_load = (ps.size() + num_threads - 1) / num_threads;
-
-    std::thread workers[num_threads];
-    for (int i = 0; i < num_threads; i++)
+    /* The darkened colors are a separate pass which vectorizes trivially */
+    for (int i = 4 * start; i < 4 * end; i++)
     {
-        int thread_start = i * worker_load;
-        int thread_end   = (i + 1) * worker_load;
-        thread_end = std::min(thread_end, (int)ps.size());
-
-        workers[i] = std::thread([=] () { spawn_worker(thread_start, thread_end); });
+        dark_color[i] = color[i] * 0.5f;
     }
 
-    for (auto& w : workers)
-    {
-        w.join();
-    }
+    particles_alive -= died;
 }
 
 void ParticleSystem::update()
@@ -164,7 +158,8 @@ void ParticleSystem::update()
     float time = (wf::get_current_time() - last_update_msec) / 16.0;
     last_update_msec = wf::get_current_time();
 
-    exec_worker_threads([=] (int start, int end)
+    wf::get_task_pool().parallel_for(size(), MIN_PARTICLES_PER_TASK,
+        [=] (int start, int end)
     {
         update_worker(time, start, end);
     });
@@ -181,6 +176,12 @@ void ParticleSystem::create_program()
     OpenGL::render_begin();
     program.set_simple(OpenGL::compile_program(particle_vert_source,
         particle_frag_source));
+    locs.position  = program.get_attrib("position");
+    locs.radius    = program.get_attrib("radius");
+    locs.center    = program.get_attrib("center");
+    locs.color     = program.get_attrib("color");
+    locs.matrix    = program.get_uniform("matrix");
+    locs.smoothing = program.get_uniform("smoothing");
     OpenGL::render_end();
 }
 
@@ -194,34 +195,34 @@ void ParticleSystem::render(glm::mat4 matrix)
         -1, 1
     };
 
-    program.attrib_pointer("position", 2, 0, vertex_data);
-    program.attrib_divisor("position", 0);
+    program.attrib_pointer(locs.position, 2, 0, vertex_data);
+    program.attrib_divisor(locs.position, 0);
 
-    program.attrib_pointer("radius", 1, 0, radius.data());
-    program.attrib_divisor("radius", 1);
+    program.attrib_pointer(locs.radius, 1, 0, radius.data());
+    program.attrib_divisor(locs.radius, 1);
 
-    program.attrib_pointer("center", 2, 0, center.data());
-    program.attrib_divisor("center", 1);
+    program.attrib_pointer(locs.center, 2, 0, center.data());
+    program.attrib_divisor(locs.center, 1);
 
     // matrix
-    program.uniformMatrix4f("matrix", matrix);
+    program.uniformMatrix4f(locs.matrix, matrix);
 
     /* Darken the background */
-    program.attrib_pointer("color", 4, 0, dark_color.data());
-    program.attrib_divisor("color", 1);
+    program.attrib_pointer(locs.color, 4, 0, dark_color.data());
+    program.attrib_divisor(locs.color, 1);
 
     GL_CALL(glEnable(GL_BLEND));
     GL_CALL(glBlendFunc(GL_ZERO, GL_ONE_MINUS_SRC_ALPHA));
-    program.uniform1f("smoothing", 0.7);
+    program.uniform1f(locs.smoothing, 0.7);
 
     // TODO: optimize shaders for this case
-    GL_CALL(glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, ps.size()));
+    GL_CALL(glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, size()));
 
     // particle color
-    program.attrib_pointer("color", 4, 0, color.data());
+    program.attrib_pointer(locs.color, 4, 0, color.data());
     GL_CALL(glBlendFunc(GL_SRC_ALPHA, GL_ONE));
-    program.uniform1f("smoothing", 0.5);
-    GL_CALL(glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, ps.size()));
+    program.uniform1f(locs.smoothing, 0.5);
+    GL_CALL(glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, size()));
 
     GL_CALL(glDisable(GL_BLEND));
     GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
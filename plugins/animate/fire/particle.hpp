@@ -6,6 +6,7 @@
 #include <atomic>
 #include <vector>
 
+/* The initial state of a particle, filled in by a ParticleIniter */
 struct Particle
 {
     float life = -1;
@@ -17,11 +18,6 @@ struct Particle
     glm::vec2 start_pos;
 
     glm::vec4 color{1.0, 1.0, 1.0, 1.0};
-
-    /* update the given particle
-     * time is the percentage of the frame which has elapsed
-     * must be thread-safe */
-    void update(float time);
 };
 
 /* a function to initialize a particle */
@@ -65,8 +61,14 @@ class ParticleSystem
     uint32_t last_update_msec;
 
     std::atomic<int> particles_alive;
-    std::vector<Particle> ps;
 
+    /* Particle state, stored as one array per component, so that the update
+     * loop can be vectorized. A particle is dead if its life is <= 0 */
+    std::vector<float> life, fade, base_radius;
+    std::vector<float> speed_x, speed_y, g_x, g_y, start_x;
+
+    /* The following arrays hold the state which is also used for rendering,
+     * in the layout the shader expects. center holds the particle positions */
     static constexpr int color_per_particle = 4;
     std::vector<float> color, dark_color;
 
@@ -77,7 +79,14 @@ class ParticleSystem
     std::vector<float> center;
 
     OpenGL::program_t program;
-    void exec_worker_threads(std::function<void(int, int)> spawn_worker);
+    struct
+    {
+        OpenGL::program_t::attrib_t position, radius, center, color;
+        OpenGL::program_t::uniform_t matrix, smoothing;
+    } locs;
+
+    /* store the initial state p as the particle at index i */
+    void store_particle(int i, const Particle& p);
     void update_worker(float time, int start, int end);
     void create_program();
 };
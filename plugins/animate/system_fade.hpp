@@ -14,21 +14,25 @@ class wf_system_fade
 
     wf::output_t *output;
 
-    wf::effect_hook_t damage_hook, render_hook;
+    wf::effect_hook_t render_hook;
+    wf::animation_driver_t animation;
 
   public:
     wf_system_fade(wf::output_t *out, int dur) :
         progression(wf::create_option<int>(dur)), output(out)
     {
-        damage_hook = [=] ()
-        { output->render->damage_whole(); };
+        animation = [=] ()
+        {
+            output->render->damage_whole();
+
+            return progression.running();
+        };
 
         render_hook = [=] ()
         { render(); };
 
-        output->render->add_effect(&damage_hook, wf::OUTPUT_EFFECT_PRE);
         output->render->add_effect(&render_hook, wf::OUTPUT_EFFECT_OVERLAY);
-        output->render->set_redraw_always();
+        output->render->add_animation_driver(&animation);
         this->progression.animate(1, 0);
     }
 
@@ -51,9 +55,8 @@ class wf_system_fade
 
     void finish()
     {
-        output->render->rem_effect(&damage_hook);
+        output->render->rem_animation_driver(&animation);
         output->render->rem_effect(&render_hook);
-        output->render->set_redraw_always(false);
 
         delete this;
     }
@@ -53,7 +53,11 @@ wf_blur_base::wf_blur_base(wf::output_t *output, std::string name)
     this->iterations_opt.set_callback(options_changed);
 
     OpenGL::render_begin();
-    blend_program.compile(blur_blend_vertex_shader, blur_blend_fragment_shader);
+    blend_program = OpenGL::get_shared_program(
+        blur_blend_vertex_shader, blur_blend_fragment_shader);
+    blend_locs.position   = blend_program->get_attrib("position");
+    blend_locs.mvp        = blend_program->get_uniform("mvp");
+    blend_locs.bg_texture = blend_program->get_uniform("bg_texture");
     OpenGL::render_end();
 }
 
@@ -62,9 +66,6 @@ wf_blur_base::~wf_blur_base()
     OpenGL::render_begin();
     fb[0].release();
     fb[1].release();
-    program[0].free_resources();
-    program[1].free_resources();
-    blend_program.free_resources();
     OpenGL::render_end();
 }
 
@@ -200,15 +201,27 @@ void wf_blur_base::pre_render(wf::texture_t src_tex, wlr_box src_box,
     OpenGL::render_end();
 }
 
+void wf_blur_base::take_blurred_background(wf::framebuffer_base_t& buffer)
+{
+    std::swap(fb[1], buffer);
+}
+
 void wf_blur_base::render(wf::texture_t src_tex, wlr_box src_box,
     wlr_box scissor_box, const wf::framebuffer_t& target_fb)
+{
+    render(src_tex, src_box, scissor_box, target_fb, fb[1]);
+}
+
+void wf_blur_base::render(wf::texture_t src_tex, wlr_box src_box,
+    wlr_box scissor_box, const wf::framebuffer_t& target_fb,
+    const wf::framebuffer_base_t& background)
 {
     wlr_box fb_geom =
         target_fb.framebuffer_box_from_geometry_box(target_fb.geometry);
     auto view_box = target_fb.framebuffer_box_from_geometry_box(src_box);
 
     OpenGL::render_begin(target_fb);
-    blend_program.use(src_tex.type);
+    blend_program->use(src_tex.type);
 
     /* Use shader and enable vertex and texcoord data */
     static const float vertexData[] = {
@@ -218,16 +231,17 @@ void wf_blur_base::render(wf::texture_t src_tex, wlr_box src_box,
         -1.0f, 1.0f
     };
 
-    blend_program.attrib_pointer("position", 2, 0, vertexData);
+    blend_program->attrib_pointer(blend_locs.position, 2, 0, vertexData);
 
     /* Blend blurred background with window texture src_tex */
-    blend_program.uniformMatrix4f("mvp", glm::inverse(target_fb.transform));
+    blend_program->uniformMatrix4f(blend_locs.mvp,
+        glm::inverse(target_fb.transform));
     /* XXX: core should give us the number of texture units used */
-    blend_program.uniform1i("bg_texture", 1);
+    blend_program->uniform1i(blend_locs.bg_texture, 1);
 
-    blend_program.set_active_texture(src_tex);
+    blend_program->set_active_texture(src_tex);
     GL_CALL(glActiveTexture(GL_TEXTURE0 + 1));
-    GL_CALL(glBindTexture(GL_TEXTURE_2D, fb[1].tex));
+    GL_CALL(glBindTexture(GL_TEXTURE_2D, background.tex));
     /* Render it to target_fb */
     target_fb.bind();
     GL_CALL(glViewport(view_box.x, fb_geom.height - view_box.y - view_box.height,
@@ -243,7 +257,7 @@ void wf_blur_base::render(wf::texture_t src_tex, wlr_box src_box,
     GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
     GL_CALL(glActiveTexture(GL_TEXTURE0));
     GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
-    blend_program.deactivate();
+    blend_program->deactivate();
     OpenGL::render_end();
 }
 
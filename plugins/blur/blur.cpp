@@ -7,21 +7,92 @@
 #include <wayfire/signal-definitions.hpp>
 
 #include "blur.hpp"
+#include <algorithm>
+#include <unordered_map>
 
 using blur_algorithm_provider = std::function<nonstd::observer_ptr<wf_blur_base>()>;
+class wf_blur_transformer;
+using blur_transformer_list = std::vector<wf_blur_transformer*>;
+
+/**
+ * What a blur transformer does with its cached background while rendering the
+ * current workspace stream. Decided in workspace-stream-pre.
+ */
+enum blur_cache_mode_t
+{
+    /* Blur the damaged region only, do not touch the cache */
+    BLUR_CACHE_NONE,
+    /* Nothing behind the view has changed, blur the whole view and keep it */
+    BLUR_CACHE_REBUILD,
+    /* Reuse the cached background if it covers the damage */
+    BLUR_CACHE_USE,
+};
+
 class wf_blur_transformer : public wf::view_transformer_t
 {
     blur_algorithm_provider provider;
     wf::output_t *output;
-    wayfire_view view;
+    blur_transformer_list *transformers;
+
+    /* The blurred background behind the view, sized to the view box */
+    wf::framebuffer_base_t cache_buffer;
+    /* The region where cache_buffer holds the background, output-local */
+    wf::region_t cache_region;
+    /* The view box and framebuffer the background was computed for */
+    wlr_box cache_src_box;
+    uint32_t cache_fb;
+    wf::geometry_t cache_fb_geometry;
+    float cache_fb_scale;
+    uint32_t cache_fb_transform;
+    /* The background blurred for the current stream, nullptr if it is in the
+     * blur algorithm's buffers */
+    const wf::framebuffer_base_t *current_background = nullptr;
+
+    bool cache_matches(wlr_box src_box, const wf::framebuffer_t& target_fb) const
+    {
+        return cache_valid && (src_box == cache_src_box) &&
+               (target_fb.fb == cache_fb) &&
+               (target_fb.geometry == cache_fb_geometry) &&
+               (target_fb.scale == cache_fb_scale) &&
+               (target_fb.wl_transform == cache_fb_transform);
+    }
 
   public:
+    wayfire_view view;
+
+    bool cache_valid = false;
+    /* Something behind the view changed since the last frame */
+    bool background_changed = true;
+    /* The padded bounding box of the view when the cache was filled */
+    wlr_box cache_box = {0, 0, 0, 0};
+    blur_cache_mode_t cache_mode = BLUR_CACHE_NONE;
+
     wf_blur_transformer(blur_algorithm_provider blur_algorithm_provider,
-        wf::output_t *output, wayfire_view view)
+        wf::output_t *output, wayfire_view view,
+        blur_transformer_list *transformers)
     {
         provider     = blur_algorithm_provider;
         this->output = output;
         this->view   = view;
+        this->transformers = transformers;
+        transformers->push_back(this);
+    }
+
+    ~wf_blur_transformer()
+    {
+        auto it = std::find(transformers->begin(), transformers->end(), this);
+        transformers->erase(it);
+
+        OpenGL::render_begin();
+        cache_buffer.release();
+        OpenGL::render_end();
+    }
+
+    /** Drop the cached background, because something behind it changed. */
+    void invalidate_cache()
+    {
+        cache_valid = false;
+        background_changed = true;
     }
 
     wf::pointf_t transform_point(wf::geometry_t view,
@@ -71,6 +142,10 @@ class wf_blur_transformer : public wf::view_transformer_t
     {
         wf::region_t clip_damage = damage & src_box;
 
+        /* The mode only applies to the stream it was decided for */
+        auto mode = cache_mode;
+        cache_mode = BLUR_CACHE_NONE;
+
         /* We want to check if the opaque region completely occludes
          * the bounding box. If this is the case, we can skip blurring
          * altogether and just render the surface. First we disable
@@ -97,9 +172,38 @@ class wf_blur_transformer : public wf::view_transformer_t
         wf::region_t opaque_region  = view->get_transformed_opaque_region();
         wf::region_t blurred_region = clip_damage ^ opaque_region;
 
-        provider()->pre_render(src_tex, src_box, blurred_region, target_fb);
+        bool use_cache = (mode == BLUR_CACHE_USE) &&
+            cache_matches(src_box, target_fb) &&
+            (blurred_region ^ cache_region).empty();
+        if (use_cache)
+        {
+            current_background = &cache_buffer;
+        } else
+        {
+            provider()->pre_render(src_tex, src_box, blurred_region, target_fb);
+            if (mode == BLUR_CACHE_REBUILD)
+            {
+                /* The whole view has been damaged in workspace-stream-pre, so
+                 * the background is complete except for occluded parts */
+                provider()->take_blurred_background(cache_buffer);
+                current_background = &cache_buffer;
+                cache_region  = blurred_region;
+                cache_src_box = src_box;
+                cache_fb = target_fb.fb;
+                cache_fb_geometry  = target_fb.geometry;
+                cache_fb_scale     = target_fb.scale;
+                cache_fb_transform = target_fb.wl_transform;
+                cache_valid = true;
+            } else if (mode == BLUR_CACHE_USE)
+            {
+                /* The view changed in a way the cache does not cover */
+                cache_valid = false;
+            }
+        }
+
         wf::view_transformer_t::render_with_damage(src_tex, src_box, blurred_region,
             target_fb);
+        current_background = nullptr;
 
         /* Opaque non-blurred regions can be rendered directly without blending */
         direct_render(src_tex, src_box, opaque_region & clip_damage, target_fb);
@@ -108,7 +212,14 @@ class wf_blur_transformer : public wf::view_transformer_t
     void render_box(wf::texture_t src_tex, wlr_box src_box, wlr_box scissor_box,
         const wf::framebuffer_t& target_fb) override
     {
-        provider()->render(src_tex, src_box, scissor_box, target_fb);
+        if (current_background)
+        {
+            provider()->render(src_tex, src_box, scissor_box, target_fb,
+                *current_background);
+        } else
+        {
+            provider()->render(src_tex, src_box, scissor_box, target_fb);
+        }
     }
 };
 
@@ -118,7 +229,7 @@ class wayfire_blur : public wf::plugin_interface_t
 
     wf::effect_hook_t frame_pre_paint;
     wf::signal_callback_t workspace_stream_pre, workspace_stream_post,
-        view_attached, view_detached;
+        view_attached, view_detached, view_damaged;
 
     const std::string normal_mode = "normal";
     std::string last_mode;
@@ -131,9 +242,15 @@ class wayfire_blur : public wf::plugin_interface_t
 
     const std::string transformer_name = "blur";
 
-    /* the pixels from padded_region */
+    /* the pixels from padded_region, stored relative to its extents */
     wf::framebuffer_base_t saved_pixels;
     wf::region_t padded_region;
+    wlr_box saved_box;
+
+    /* all blur transformers of views on this output */
+    blur_transformer_list transformers;
+    /* damage caused by each view since the last frame */
+    std::unordered_map<wf::view_interface_t*, wf::region_t> view_damage;
 
     void add_transformer(wayfire_view view)
     {
@@ -144,7 +261,7 @@ class wayfire_blur : public wf::plugin_interface_t
 
         view->add_transformer(std::make_unique<wf_blur_transformer>(
             [=] () {return nonstd::make_observer(blur_algorithm.get()); },
-            output, view),
+            output, view, &transformers),
             transformer_name);
     }
 
@@ -178,6 +295,85 @@ class wayfire_blur : public wf::plugin_interface_t
         return result;
     }
 
+    int get_padding(const wf::framebuffer_t& fb) const
+    {
+        return std::ceil(blur_algorithm->calculate_blur_radius() / fb.scale);
+    }
+
+    /** The region around the view from which blur samples, output-local */
+    wlr_box get_sampled_box(wayfire_view view, int padding) const
+    {
+        auto box = view->get_bounding_box();
+        return {box.x - padding, box.y - padding,
+            box.width + 2 * padding, box.height + 2 * padding};
+    }
+
+    /**
+     * Decide for each blurred view on the stream whether its cached
+     * background can be used. Views which have no valid cache, but nothing
+     * changed behind them, get their whole area damaged so that the cache
+     * can be filled in this frame.
+     */
+    void update_cache_modes(const wf::stream_signal_t& ev, wf::region_t& damage)
+    {
+        /* Damage is only attributed to views on the visible workspace */
+        bool is_current_ws = (ev.ws == output->workspace->get_current_workspace());
+        int padding = get_padding(ev.fb);
+        auto ws_box = output->render->get_ws_box(ev.ws);
+
+        for (auto& tr : transformers)
+        {
+            tr->cache_mode = BLUR_CACHE_NONE;
+            if (!is_current_ws || !tr->view->is_visible() ||
+                (tr->view->role == wf::VIEW_ROLE_DESKTOP_ENVIRONMENT))
+            {
+                continue;
+            }
+
+            auto box = get_sampled_box(tr->view, padding);
+            if ((damage & box).empty())
+            {
+                continue;
+            }
+
+            if (tr->cache_valid && (box == tr->cache_box))
+            {
+                tr->cache_mode = BLUR_CACHE_USE;
+            } else if (!tr->background_changed)
+            {
+                tr->cache_mode = BLUR_CACHE_REBUILD;
+                tr->cache_box  = box;
+                damage |= wf::geometry_intersection(box, ws_box);
+            }
+
+            tr->background_changed = false;
+        }
+    }
+
+    /**
+     * Drop the caches of the views behind the region returned by
+     * get_region for each of them.
+     */
+    template<class RegionGetter>
+    void invalidate_caches(RegionGetter get_region)
+    {
+        int padding = get_padding(output->render->get_target_framebuffer());
+        for (auto& tr : transformers)
+        {
+            if (tr->background_changed && !tr->cache_valid)
+            {
+                continue;
+            }
+
+            auto box = tr->cache_valid ? tr->cache_box :
+                get_sampled_box(tr->view, padding);
+            if (!(get_region(tr) & box).empty())
+            {
+                tr->invalidate_cache();
+            }
+        }
+    }
+
   public:
     void init() override
     {
@@ -286,6 +482,21 @@ class wayfire_blur : public wf::plugin_interface_t
         output->connect_signal("view-mapped", &view_attached);
         output->connect_signal("view-detached", &view_detached);
 
+        /* Damage from a view does not change the background behind itself,
+         * so it does not need to invalidate its own cached background */
+        view_damaged = [=] (wf::signal_data_t *data)
+        {
+            auto ev = static_cast<wf::view_region_damaged_signal*>(data);
+            view_damage[ev->view.get()] |= ev->box;
+
+            invalidate_caches([&] (wf_blur_transformer *tr)
+            {
+                return tr->view == ev->view ? wf::region_t{} :
+                       wf::region_t{ev->box};
+            });
+        };
+        output->connect_signal("view-region-damaged", &view_damaged);
+
         /* frame_pre_paint is called before each frame has started.
          * It expands the damage by the blur radius.
          * This is needed, because when blurring, the pixels that changed
@@ -296,8 +507,23 @@ class wayfire_blur : public wf::plugin_interface_t
             auto damage    = output->render->get_scheduled_damage();
             const auto& fb = output->render->get_target_framebuffer();
 
-            int padding = std::ceil(
-                blur_algorithm->calculate_blur_radius() / fb.scale);
+            /* Any damage, e.g. by plugins or by other views, may change the
+             * background of the blurred views. Only the damage which a view
+             * caused itself is exempted for that view, since it does not
+             * change what is behind it. */
+            if (!damage.empty())
+            {
+                invalidate_caches([&] (wf_blur_transformer *tr)
+                {
+                    auto it = view_damage.find(tr->view.get());
+                    return it == view_damage.end() ? damage :
+                           damage ^ it->second;
+                });
+            }
+
+            view_damage.clear();
+
+            int padding = get_padding(fb);
             wf::surface_interface_t::set_opaque_shrink_constraint("blur",
                 padding);
 
@@ -328,11 +554,12 @@ class wayfire_blur : public wf::plugin_interface_t
             const auto& ws = static_cast<wf::stream_signal_t*>(data)->ws;
             const auto& target_fb = static_cast<wf::stream_signal_t*>(data)->fb;
 
+            update_cache_modes(*static_cast<wf::stream_signal_t*>(data), damage);
+
             /* As long as the padding is big enough to cover the
              * furthest sampled pixel by the shader, there should
              * be no visual artifacts. */
-            int padding = std::ceil(
-                blur_algorithm->calculate_blur_radius() / target_fb.scale);
+            int padding = get_padding(target_fb);
 
             wf::region_t expanded_damage;
             for (const auto& rect : damage)
@@ -354,10 +581,18 @@ class wayfire_blur : public wf::plugin_interface_t
             padded_region = get_fb_region(expanded_damage, target_fb) ^
                 get_fb_region(damage, target_fb);
 
+            /* This effectively makes damage the same as expanded_damage. */
+            damage |= expanded_damage;
+            if (padded_region.empty())
+            {
+                return;
+            }
+
             OpenGL::render_begin(target_fb);
-            /* Initialize a place to store padded region pixels. */
-            saved_pixels.allocate(target_fb.viewport_width,
-                target_fb.viewport_height);
+            /* Initialize a place to store padded region pixels. Only the
+             * extents of the padded region are stored. */
+            saved_box = wlr_box_from_pixman_box(padded_region.get_extents());
+            saved_pixels.allocate(saved_box.width, saved_box.height);
 
             /* Setup framebuffer I/O. target_fb contains the pixels
              * from last frame at this point. We are writing them
@@ -371,12 +606,11 @@ class wayfire_blur : public wf::plugin_interface_t
                 GL_CALL(glBlitFramebuffer(
                     box.x1, target_fb.viewport_height - box.y2,
                     box.x2, target_fb.viewport_height - box.y1,
-                    box.x1, box.y1, box.x2, box.y2,
+                    box.x1 - saved_box.x, box.y1 - saved_box.y,
+                    box.x2 - saved_box.x, box.y2 - saved_box.y,
                     GL_COLOR_BUFFER_BIT, GL_LINEAR));
             }
 
-            /* This effectively makes damage the same as expanded_damage. */
-            damage |= expanded_damage;
             GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
             OpenGL::render_end();
         };
@@ -391,6 +625,11 @@ class wayfire_blur : public wf::plugin_interface_t
         workspace_stream_post = [=] (wf::signal_data_t *data)
         {
             const auto& target_fb = static_cast<wf::stream_signal_t*>(data)->fb;
+            if (padded_region.empty())
+            {
+                return;
+            }
+
             OpenGL::render_begin(target_fb);
             /* Setup framebuffer I/O. target_fb contains the frame
              * rendered with expanded damage and artifacts on the edges.
@@ -401,7 +640,9 @@ class wayfire_blur : public wf::plugin_interface_t
             /* Copy pixels back from saved_pixels to target_fb. */
             for (const auto& box : padded_region)
             {
-                GL_CALL(glBlitFramebuffer(box.x1, box.y1, box.x2, box.y2,
+                GL_CALL(glBlitFramebuffer(
+                    box.x1 - saved_box.x, box.y1 - saved_box.y,
+                    box.x2 - saved_box.x, box.y2 - saved_box.y,
                     box.x1, target_fb.viewport_height - box.y2,
                     box.x2, target_fb.viewport_height - box.y1,
                     GL_COLOR_BUFFER_BIT, GL_LINEAR));
@@ -425,6 +666,7 @@ class wayfire_blur : public wf::plugin_interface_t
         output->disconnect_signal("view-attached", &view_attached);
         output->disconnect_signal("view-mapped", &view_attached);
         output->disconnect_signal("view-detached", &view_detached);
+        output->disconnect_signal("view-region-damaged", &view_damaged);
         output->render->rem_effect(&frame_pre_paint);
         output->render->disconnect_signal("workspace-stream-pre",
             &workspace_stream_pre);
@@ -91,11 +91,17 @@ class wf_blur_base
     /* used to store temporary results in blur algorithms, cleaned up in base
      * destructor */
     wf::framebuffer_base_t fb[2];
-    /* the program created by the given algorithm, cleaned up in base destructor */
-    OpenGL::program_t program[2];
+    /* the programs created by the given algorithm, shared between outputs */
+    std::shared_ptr<OpenGL::program_t> program[2];
     /* the program used by wf_blur_base to combine the blurred, unblurred and
      * view texture */
-    OpenGL::program_t blend_program;
+    std::shared_ptr<OpenGL::program_t> blend_program;
+    /* cached uniform and attribute handles of blend_program */
+    struct
+    {
+        OpenGL::program_t::attrib_t position;
+        OpenGL::program_t::uniform_t mvp, bg_texture;
+    } blend_locs;
 
     /* used to get individual algorithm options from config
      * should be set by the constructor */
@@ -134,6 +140,16 @@ class wf_blur_base
 
     virtual void render(wf::texture_t src_tex, wlr_box src_box,
         wlr_box scissor_box, const wf::framebuffer_t& target_fb);
+
+    /* same as render(), but blends with a blurred background previously
+     * obtained with take_blurred_background() */
+    void render(wf::texture_t src_tex, wlr_box src_box,
+        wlr_box scissor_box, const wf::framebuffer_t& target_fb,
+        const wf::framebuffer_base_t& background);
+
+    /* exchange the blurred background computed by the last pre_render() with
+     * the given buffer, so that it can be reused in later frames */
+    void take_blurred_background(wf::framebuffer_base_t& buffer);
 };
 
 std::unique_ptr<wf_blur_base> create_box_blur(wf::output_t *output);
@@ -57,11 +57,22 @@ void main()
 class wf_bokeh_blur : public wf_blur_base
 {
   public:
+    /* cached uniform and attribute handles of the program */
+    struct
+    {
+        OpenGL::program_t::attrib_t position;
+        OpenGL::program_t::uniform_t halfpixel, offset, iterations;
+    } locs;
+
     wf_bokeh_blur(wf::output_t *output) : wf_blur_base(output, "bokeh")
     {
         OpenGL::render_begin();
-        program[0].set_simple(OpenGL::compile_program(bokeh_vertex_shader,
-            bokeh_fragment_shader));
+        program[0] = OpenGL::get_shared_simple_program(bokeh_vertex_shader,
+            bokeh_fragment_shader);
+        locs.position   = program[0]->get_attrib("position");
+        locs.halfpixel  = program[0]->get_uniform("halfpixel");
+        locs.offset     = program[0]->get_uniform("offset");
+        locs.iterations = program[0]->get_uniform("iterations");
         OpenGL::render_end();
     }
 
@@ -79,12 +90,12 @@ class wf_bokeh_blur : public wf_blur_base
 
         OpenGL::render_begin();
         /* Upload data to shader */
-        program[0].use(wf::TEXTURE_TYPE_RGBA);
-        program[0].uniform2f("halfpixel", 0.5f / width, 0.5f / height);
-        program[0].uniform1f("offset", offset);
-        program[0].uniform1i("iterations", iterations);
+        program[0]->use(wf::TEXTURE_TYPE_RGBA);
+        program[0]->uniform2f(locs.halfpixel, 0.5f / width, 0.5f / height);
+        program[0]->uniform1f(locs.offset, offset);
+        program[0]->uniform1i(locs.iterations, iterations);
 
-        program[0].attrib_pointer("position", 2, 0, vertexData);
+        program[0]->attrib_pointer(locs.position, 2, 0, vertexData);
         GL_CALL(glDisable(GL_BLEND));
         render_iteration(blur_region, fb[0], fb[1], width, height);
 
@@ -92,7 +103,7 @@ class wf_bokeh_blur : public wf_blur_base
         GL_CALL(glEnable(GL_BLEND));
         GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
 
-        program[0].deactivate();
+        program[0]->deactivate();
         GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
         OpenGL::render_end();
 
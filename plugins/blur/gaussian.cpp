@@ -70,13 +70,29 @@ void main()
 class wf_gaussian_blur : public wf_blur_base
 {
   public:
+    /* cached uniform and attribute handles of the two programs */
+    struct
+    {
+        OpenGL::program_t::attrib_t position;
+        OpenGL::program_t::uniform_t size, offset;
+    } locs[2];
+
+    void get_id_locations(int i)
+    {
+        locs[i].position = program[i]->get_attrib("position");
+        locs[i].size     = program[i]->get_uniform("size");
+        locs[i].offset   = program[i]->get_uniform("offset");
+    }
+
     wf_gaussian_blur(wf::output_t *output) : wf_blur_base(output, "gaussian")
     {
         OpenGL::render_begin();
-        program[0].set_simple(OpenGL::compile_program(
-            gaussian_vertex_shader, gaussian_fragment_shader_horz));
-        program[1].set_simple(OpenGL::compile_program(
-            gaussian_vertex_shader, gaussian_fragment_shader_vert));
+        program[0] = OpenGL::get_shared_simple_program(
+            gaussian_vertex_shader, gaussian_fragment_shader_horz);
+        program[1] = OpenGL::get_shared_simple_program(
+            gaussian_vertex_shader, gaussian_fragment_shader_vert);
+        get_id_locations(0);
+        get_id_locations(1);
         OpenGL::render_end();
     }
 
@@ -90,15 +106,15 @@ class wf_gaussian_blur : public wf_blur_base
             -1.0f, 1.0f
         };
 
-        program[i].use(wf::TEXTURE_TYPE_RGBA);
-        program[i].uniform2f("size", width, height);
-        program[i].uniform1f("offset", offset);
-        program[i].attrib_pointer("position", 2, 0, vertexData);
+        program[i]->use(wf::TEXTURE_TYPE_RGBA);
+        program[i]->uniform2f(locs[i].size, width, height);
+        program[i]->uniform1f(locs[i].offset, offset);
+        program[i]->attrib_pointer(locs[i].position, 2, 0, vertexData);
     }
 
     void blur(const wf::region_t& blur_region, int i, int width, int height)
     {
-        program[i].use(wf::TEXTURE_TYPE_RGBA);
+        program[i]->use(wf::TEXTURE_TYPE_RGBA);
         render_iteration(blur_region, fb[i], fb[!i], width, height);
     }
 
@@ -128,7 +144,7 @@ class wf_gaussian_blur : public wf_blur_base
         GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
 
         GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
-        program[1].deactivate();
+        program[1]->deactivate();
         OpenGL::render_end();
 
         return 0;
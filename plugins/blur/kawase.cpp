@@ -60,14 +60,28 @@ void main()
 class wf_kawase_blur : public wf_blur_base
 {
   public:
+    /* cached uniform and attribute handles of the two programs */
+    struct
+    {
+        OpenGL::program_t::attrib_t position;
+        OpenGL::program_t::uniform_t offset, halfpixel;
+    } locs[2];
+
     wf_kawase_blur(wf::output_t *output) :
         wf_blur_base(output, "kawase")
     {
         OpenGL::render_begin();
-        program[0].set_simple(OpenGL::compile_program(kawase_vertex_shader,
-            kawase_fragment_shader_down));
-        program[1].set_simple(OpenGL::compile_program(kawase_vertex_shader,
-            kawase_fragment_shader_down_up));
+        program[0] = OpenGL::get_shared_simple_program(kawase_vertex_shader,
+            kawase_fragment_shader_down);
+        program[1] = OpenGL::get_shared_simple_program(kawase_vertex_shader,
+            kawase_fragment_shader_down_up);
+        for (int i = 0; i < 2; i++)
+        {
+            locs[i].position  = program[i]->get_attrib("position");
+            locs[i].offset    = program[i]->get_uniform("offset");
+            locs[i].halfpixel = program[i]->get_uniform("halfpixel");
+        }
+
         OpenGL::render_end();
     }
 
@@ -86,14 +100,14 @@ class wf_kawase_blur : public wf_blur_base
         };
 
         OpenGL::render_begin();
-        program[0].use(wf::TEXTURE_TYPE_RGBA);
+        program[0]->use(wf::TEXTURE_TYPE_RGBA);
 
         /* Downsample */
-        program[0].attrib_pointer("position", 2, 0, vertexData);
+        program[0]->attrib_pointer(locs[0].position, 2, 0, vertexData);
         /* Disable blending, because we may have transparent background, which
          * we want to render on uncleared framebuffer */
         GL_CALL(glDisable(GL_BLEND));
-        program[0].uniform1f("offset", offset);
+        program[0]->uniform1f(locs[0].offset, offset);
 
         for (int i = 0; i < iterations; i++)
         {
@@ -102,18 +116,18 @@ class wf_kawase_blur : public wf_blur_base
 
             auto region = blur_region * (1.0 / (1 << i));
 
-            program[0].uniform2f("halfpixel",
+            program[0]->uniform2f(locs[0].halfpixel,
                 0.5f / sampleWidth, 0.5f / sampleHeight);
             render_iteration(region, fb[i % 2], fb[1 - i % 2], sampleWidth,
                 sampleHeight);
         }
 
-        program[0].deactivate();
+        program[0]->deactivate();
 
         /* Upsample */
-        program[1].use(wf::TEXTURE_TYPE_RGBA);
-        program[1].attrib_pointer("position", 2, 0, vertexData);
-        program[1].uniform1f("offset", offset);
+        program[1]->use(wf::TEXTURE_TYPE_RGBA);
+        program[1]->attrib_pointer(locs[1].position, 2, 0, vertexData);
+        program[1]->uniform1f(locs[1].offset, offset);
         for (int i = iterations - 1; i >= 0; i--)
         {
             sampleWidth  = width / (1 << i);
@@ -121,7 +135,7 @@ class wf_kawase_blur : public wf_blur_base
 
             auto region = blur_region * (1.0 / (1 << i));
 
-            program[1].uniform2f("halfpixel",
+            program[1]->uniform2f(locs[1].halfpixel,
                 0.5f / sampleWidth, 0.5f / sampleHeight);
             render_iteration(region, fb[1 - i % 2], fb[i % 2], sampleWidth,
                 sampleHeight);
@@ -131,7 +145,7 @@ class wf_kawase_blur : public wf_blur_base
         GL_CALL(glEnable(GL_BLEND));
         GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
 
-        program[1].deactivate();
+        program[1]->deactivate();
         GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
         OpenGL::render_end();
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <wayfire/plugins/common/simple-texture.hpp>
+#include <wayfire/geometry.hpp>
 #include <cairo.h>
 
 namespace wf
@@ -8,27 +9,43 @@ namespace wf
 struct simple_texture_t;
 }
 
+/**
+ * Upload the given box of the cairo surface to the same place in the texture,
+ * which must have the size of the surface and be bound already.
+ */
+inline void cairo_surface_upload_box(cairo_surface_t *surface,
+    wf::geometry_t box)
+{
+    int stride = cairo_image_surface_get_stride(surface);
+    GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+    GL_CALL(glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / 4));
+    GL_CALL(glPixelStorei(GL_UNPACK_SKIP_PIXELS, box.x));
+    GL_CALL(glPixelStorei(GL_UNPACK_SKIP_ROWS, box.y));
+    GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, box.x, box.y,
+        box.width, box.height, GL_RGBA, GL_UNSIGNED_BYTE,
+        cairo_image_surface_get_data(surface)));
+
+    /* Other uploads expect the default unpack state */
+    GL_CALL(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+    GL_CALL(glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0));
+    GL_CALL(glPixelStorei(GL_UNPACK_SKIP_ROWS, 0));
+}
+
 /**
  * Upload the data from the cairo surface to the OpenGL texture.
  *
+ * The texture storage is reused if it already has the size of the surface.
+ *
  * @param surface The source cairo surface.
  * @param buffer  The buffer to upload data to.
  */
-static void cairo_surface_upload_to_texture(
+inline void cairo_surface_upload_to_texture(
     cairo_surface_t *surface, wf::simple_texture_t& buffer)
 {
-    buffer.width  = cairo_image_surface_get_width(surface);
-    buffer.height = cairo_image_surface_get_height(surface);
-    if (buffer.tex == (GLuint) - 1)
-    {
-        GL_CALL(glGenTextures(1, &buffer.tex));
-    }
-
-    auto src = cairo_image_surface_get_data(surface);
+    cairo_surface_flush(surface);
+    buffer.allocate(cairo_image_surface_get_width(surface),
+        cairo_image_surface_get_height(surface));
 
     GL_CALL(glBindTexture(GL_TEXTURE_2D, buffer.tex));
-    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-    GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-    GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
-        buffer.width, buffer.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, src));
+    cairo_surface_upload_box(surface, {0, 0, buffer.width, buffer.height});
 }
@@ -24,6 +24,7 @@ class preview_indication_animation_t : public geometry_animation_t
 class preview_indication_view_t : public wf::color_rect_view_t
 {
     wf::effect_hook_t pre_paint;
+    wf::animation_driver_t animation_driver;
     wf::output_t *output;
 
     /* Default colors */
@@ -54,6 +55,9 @@ class preview_indication_view_t : public wf::color_rect_view_t
         pre_paint = [=] () { update_animation(); };
         get_output()->render->add_effect(&pre_paint, wf::OUTPUT_EFFECT_PRE);
 
+        animation_driver = [=] () { return animation.running(); };
+        get_output()->render->add_animation_driver(&animation_driver);
+
         set_color(base_color);
         set_border_color(base_border);
         set_border(base_border_w);
@@ -86,6 +90,7 @@ class preview_indication_view_t : public wf::color_rect_view_t
         animation.alpha.restart_with_end(alpha);
         animation.start();
         this->should_close = close;
+        this->output->render->schedule_redraw();
     }
 
     /**
@@ -101,6 +106,7 @@ class preview_indication_view_t : public wf::color_rect_view_t
     virtual ~preview_indication_view_t()
     {
         this->output->render->rem_effect(&pre_paint);
+        this->output->render->rem_animation_driver(&animation_driver);
     }
 
   protected:
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+
+namespace wf
+{
+/**
+ * Packs rectangles into a fixed-size area, for example glyphs or icons into
+ * a texture atlas.
+ *
+ * The area is filled in rows (shelves) from top to bottom, and each shelf is
+ * filled from left to right. A shelf is as high as the highest rectangle in
+ * it. This wastes some space when the rectangles have very different heights,
+ * but packing is O(1) and rectangles are never moved.
+ */
+class shelf_packer_t
+{
+  public:
+    shelf_packer_t(int width, int height) : width(width), height(height)
+    {}
+
+    /**
+     * Reserve space for a rectangle of the given size.
+     *
+     * @param x, y Set to the top-left corner of the reserved space.
+     * @return false if the rectangle does not fit anymore.
+     */
+    bool pack(int rect_width, int rect_height, int& x, int& y)
+    {
+        if (shelf_x + rect_width > width)
+        {
+            shelf_x = 0;
+            shelf_y += shelf_height;
+            shelf_height = 0;
+        }
+
+        if ((rect_width > width) || (shelf_y + rect_height > height))
+        {
+            return false;
+        }
+
+        x = shelf_x;
+        y = shelf_y;
+        shelf_x += rect_width;
+        shelf_height = std::max(shelf_height, rect_height);
+
+        return true;
+    }
+
+    /** Forget all rectangles and pack from the top-left corner again. */
+    void reset()
+    {
+        shelf_x = shelf_y = shelf_height = 0;
+    }
+
+  private:
+    int width, height;
+    int shelf_x = 0, shelf_y = 0, shelf_height = 0;
+};
+}
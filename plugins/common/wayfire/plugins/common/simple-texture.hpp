@@ -10,6 +10,38 @@ struct simple_texture_t : public noncopyable_t
     int width  = 0;
     int height = 0;
 
+    /**
+     * Make sure the texture has RGBA storage with the given size. Existing
+     * storage is kept if the size matches, its contents are undefined
+     * otherwise. Must be called between OpenGL::render_begin()/end().
+     *
+     * @return Whether new storage was allocated.
+     */
+    bool allocate(int width, int height)
+    {
+        if ((this->tex != (GLuint) - 1) &&
+            (this->width == width) && (this->height == height))
+        {
+            return false;
+        }
+
+        if (this->tex == (GLuint) - 1)
+        {
+            GL_CALL(glGenTextures(1, &tex));
+        }
+
+        this->width  = width;
+        this->height = height;
+
+        GL_CALL(glBindTexture(GL_TEXTURE_2D, tex));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+        GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
+            width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL));
+
+        return true;
+    }
+
     /**
      * Destroy the GL texture.
      * This will call OpenGL::render_begin()/end() internally.
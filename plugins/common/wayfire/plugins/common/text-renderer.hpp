@@ -0,0 +1,458 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <cmath>
+#include <unordered_map>
+#include <cairo.h>
+#include <wayfire/nonstd/noncopyable.hpp>
+#include <wayfire/object.hpp>
+#include <wayfire/core.hpp>
+#include <wayfire/opengl.hpp>
+#include <wayfire/plugins/common/shelf-packer.hpp>
+
+namespace wf
+{
+/**
+ * Draws text with OpenGL from a cache of rasterized glyphs.
+ *
+ * Each glyph is rasterized with cairo once for a given font and size, and
+ * stored in a single texture atlas. A line of text is then drawn as a batch of
+ * textured quads with a single draw call, so text which changes often, or is
+ * drawn at many places, does not need to be rasterized and uploaded as a whole.
+ *
+ * Glyphs are laid out with cairo's toy text API, like cairo_show_text(). The
+ * quads of the last few lines of text are kept, so drawing the same text again,
+ * for example once per damaged rectangle, does not lay it out again.
+ */
+class text_renderer_t : public noncopyable_t, public wf::custom_data_t
+{
+  public:
+    /**
+     * Make sure there is a text renderer stored in core, shared by all
+     * plugins, and increase its reference count.
+     */
+    static nonstd::observer_ptr<text_renderer_t> ensure_renderer()
+    {
+        if (!wf::get_core().has_data<text_renderer_t>())
+        {
+            wf::get_core().store_data(std::unique_ptr<text_renderer_t>(
+                new text_renderer_t()));
+        }
+
+        auto renderer = wf::get_core().get_data<text_renderer_t>();
+        ++renderer->ref_count;
+
+        return renderer;
+    }
+
+    /**
+     * Decrease the reference count, and if no more references are being held,
+     * then destroy the text renderer.
+     */
+    void unref()
+    {
+        --ref_count;
+        if (ref_count == 0)
+        {
+            wf::get_core().erase_data<text_renderer_t>();
+        }
+    }
+
+    ~text_renderer_t()
+    {
+        for (auto& [key, font] : fonts)
+        {
+            cairo_scaled_font_destroy(font.font);
+        }
+
+        OpenGL::render_begin();
+        program.free_resources();
+        GL_CALL(glDeleteTextures(1, &atlas));
+        OpenGL::render_end();
+    }
+
+    /**
+     * Draw a single line of text. Must be called between
+     * OpenGL::render_begin(fb) and OpenGL::render_end().
+     *
+     * @param fb The target framebuffer.
+     * @param box The box to draw the text in, in the logical coordinates of
+     *   the framebuffer. Text outside of the box is cut off.
+     * @param text The text to draw, in UTF-8.
+     * @param family The font family.
+     * @param font_size The font size, in the logical coordinates of the
+     *   framebuffer. The baseline is placed at this distance from the top of
+     *   the box.
+     * @param color The text color, not premultiplied.
+     */
+    void render(const wf::framebuffer_t& fb, wf::geometry_t box,
+        const std::string& text, const std::string& family, float font_size,
+        wf::color_t color)
+    {
+        int pixel_size = std::round(font_size * fb.scale);
+        if (text.empty() || (pixel_size <= 0))
+        {
+            return;
+        }
+
+        layout_key_t key{text, family, pixel_size, box, fb.scale};
+        auto it = layouts.find(key);
+        if (it == layouts.end())
+        {
+            quads_t quads;
+            if (!shape(fb, key, quads))
+            {
+                return;
+            }
+
+            if (layouts.size() >= MAX_LAYOUTS)
+            {
+                layouts.clear();
+            }
+
+            it = layouts.emplace(std::move(key), std::move(quads)).first;
+        }
+
+        const auto& quads = it->second;
+        if (quads.vertices.empty())
+        {
+            return;
+        }
+
+        float alpha = color.a;
+        glm::vec4 premultiplied{color.r * alpha, color.g * alpha, color.b * alpha,
+            alpha};
+
+        program.use(wf::TEXTURE_TYPE_RGBA);
+        program.set_active_texture(wf::texture_t{atlas});
+        program.attrib_pointer(position_attrib, 2, 0, quads.vertices.data());
+        program.attrib_pointer(uv_attrib, 2, 0, quads.uvs.data());
+        program.uniformMatrix4f(mvp_uniform, fb.get_orthographic_projection());
+        program.uniform4f(color_uniform, premultiplied);
+
+        GL_CALL(glEnable(GL_BLEND));
+        GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+        GL_CALL(glDrawArrays(GL_TRIANGLES, 0, quads.vertices.size() / 2));
+        program.deactivate();
+    }
+
+  private:
+    /* Width and height of the atlas texture */
+    static constexpr int ATLAS_SIZE = 1024;
+    /* Number of laid out lines of text to keep */
+    static constexpr size_t MAX_LAYOUTS = 64;
+
+    struct glyph_t
+    {
+        /* Position of the glyph image in the atlas, without the padding */
+        int x, y, width, height;
+        /* Offset of the glyph image from the pen position */
+        int left, top;
+    };
+
+    struct font_t
+    {
+        cairo_scaled_font_t *font;
+        /* Rasterized glyphs by glyph index */
+        std::unordered_map<unsigned long, glyph_t> glyphs;
+    };
+
+    /* Everything the quads of a line of text depend on */
+    struct layout_key_t
+    {
+        std::string text, family;
+        int pixel_size;
+        wf::geometry_t box;
+        float scale;
+
+        bool operator <(const layout_key_t& other) const
+        {
+            return std::tie(text, family, pixel_size, box.x, box.y, box.width,
+                box.height, scale) < std::tie(other.text, other.family,
+                other.pixel_size, other.box.x, other.box.y, other.box.width,
+                other.box.height, other.scale);
+        }
+    };
+
+    /* Vertex data for drawing a line of text */
+    struct quads_t
+    {
+        std::vector<GLfloat> vertices, uvs;
+    };
+
+    uint32_t ref_count = 0;
+
+    GLuint atlas = 0;
+    shelf_packer_t packer{ATLAS_SIZE, ATLAS_SIZE};
+
+    /* Fonts by family and pixel size */
+    std::map<std::pair<std::string, int>, font_t> fonts;
+
+    OpenGL::program_t program;
+    OpenGL::program_t::attrib_t position_attrib, uv_attrib;
+    OpenGL::program_t::uniform_t mvp_uniform, color_uniform;
+
+    /* Laid out lines of text. They refer to places in the atlas, so they are
+     * dropped together with its glyphs. */
+    std::map<layout_key_t, quads_t> layouts;
+
+    text_renderer_t()
+    {
+        static const char *vertex_source =
+            R"(
+#version 100
+
+attribute mediump vec2 position;
+attribute mediump vec2 uvPosition;
+varying mediump vec2 uvpos;
+
+uniform mat4 MVP;
+
+void main() {
+    gl_Position = MVP * vec4(position.xy, 0.0, 1.0);
+    uvpos = uvPosition;
+})";
+
+        static const char *fragment_source =
+            R"(
+#version 100
+@builtin_ext@
+@builtin@
+
+varying mediump vec2 uvpos;
+uniform mediump vec4 color;
+
+void main()
+{
+    gl_FragColor = color * get_pixel(uvpos).a;
+})";
+
+        OpenGL::render_begin();
+        program.compile(vertex_source, fragment_source);
+        position_attrib = program.get_attrib("position");
+        uv_attrib     = program.get_attrib("uvPosition");
+        mvp_uniform   = program.get_uniform("MVP");
+        color_uniform = program.get_uniform("color");
+
+        GL_CALL(glGenTextures(1, &atlas));
+        GL_CALL(glBindTexture(GL_TEXTURE_2D, atlas));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
+            GL_CLAMP_TO_EDGE));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
+            GL_CLAMP_TO_EDGE));
+        GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, ATLAS_SIZE, ATLAS_SIZE,
+            0, GL_RGBA, GL_UNSIGNED_BYTE, NULL));
+        GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
+        OpenGL::render_end();
+    }
+
+    font_t& get_font(const std::string& family, int pixel_size)
+    {
+        auto it = fonts.find({family, pixel_size});
+        if (it != fonts.end())
+        {
+            return it->second;
+        }
+
+        auto face = cairo_toy_font_face_create(family.c_str(),
+            CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+        auto options = cairo_font_options_create();
+
+        cairo_matrix_t font_matrix, ctm;
+        cairo_matrix_init_scale(&font_matrix, pixel_size, pixel_size);
+        cairo_matrix_init_identity(&ctm);
+
+        auto& font = fonts[{family, pixel_size}];
+        font.font = cairo_scaled_font_create(face, &font_matrix, &ctm, options);
+
+        cairo_font_options_destroy(options);
+        cairo_font_face_destroy(face);
+
+        return font;
+    }
+
+    /** Forget all glyphs and reuse the atlas from the start */
+    void reset_atlas()
+    {
+        layouts.clear();
+        for (auto& [key, font] : fonts)
+        {
+            font.glyphs.clear();
+        }
+
+        packer.reset();
+    }
+
+    /**
+     * Rasterize the glyph and store it in the atlas, if it is not there yet.
+     *
+     * @return The glyph, or nullptr if the atlas is full.
+     */
+    const glyph_t *get_glyph(font_t& font, unsigned long index)
+    {
+        auto it = font.glyphs.find(index);
+        if (it != font.glyphs.end())
+        {
+            return &it->second;
+        }
+
+        cairo_glyph_t glyph{index, 0, 0};
+        cairo_text_extents_t extents;
+        cairo_scaled_font_glyph_extents(font.font, &glyph, 1, &extents);
+
+        glyph_t result;
+        result.left   = std::floor(extents.x_bearing);
+        result.top    = std::floor(extents.y_bearing);
+        result.width  = std::ceil(extents.x_bearing + extents.width) - result.left;
+        result.height = std::ceil(extents.y_bearing + extents.height) - result.top;
+        result.x = result.y = 0;
+
+        /* Glyphs without an image, i.e spaces */
+        if ((result.width <= 0) || (result.height <= 0))
+        {
+            result.width = result.height = 0;
+            return &(font.glyphs[index] = result);
+        }
+
+        /* Each glyph is surrounded by a transparent border, so that sampling
+         * at its edges does not pick up the neighbouring glyphs */
+        int slot_width  = result.width + 2;
+        int slot_height = result.height + 2;
+        int slot_x, slot_y;
+        if (!packer.pack(slot_width, slot_height, slot_x, slot_y))
+        {
+            return nullptr;
+        }
+
+        result.x = slot_x + 1;
+        result.y = slot_y + 1;
+
+        /* ARGB32 rows are always tightly packed, as GLES2 requires */
+        auto surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+            slot_width, slot_height);
+        auto cr = cairo_create(surface);
+        cairo_set_scaled_font(cr, font.font);
+        cairo_set_source_rgba(cr, 1, 1, 1, 1);
+        glyph.x = 1 - result.left;
+        glyph.y = 1 - result.top;
+        cairo_show_glyphs(cr, &glyph, 1);
+        cairo_destroy(cr);
+        cairo_surface_flush(surface);
+
+        /* Only the alpha channel is sampled, so the byte order of cairo's
+         * ARGB32 does not matter */
+        GL_CALL(glBindTexture(GL_TEXTURE_2D, atlas));
+        GL_CALL(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+        GL_CALL(glTexSubImage2D(GL_TEXTURE_2D, 0, result.x - 1, result.y - 1,
+            slot_width, slot_height, GL_RGBA, GL_UNSIGNED_BYTE,
+            cairo_image_surface_get_data(surface)));
+        cairo_surface_destroy(surface);
+
+        return &(font.glyphs[index] = result);
+    }
+
+    /**
+     * Convert the text to glyphs and generate their quads.
+     *
+     * @return false if cairo could not convert the text.
+     */
+    bool shape(const wf::framebuffer_t& fb, const layout_key_t& key,
+        quads_t& quads)
+    {
+        auto& font = get_font(key.family, key.pixel_size);
+
+        cairo_glyph_t *glyphs = NULL;
+        int nr_glyphs = 0;
+        auto status   = cairo_scaled_font_text_to_glyphs(font.font, 0,
+            key.pixel_size, key.text.c_str(), key.text.length(),
+            &glyphs, &nr_glyphs, NULL, NULL, NULL);
+        if (status != CAIRO_STATUS_SUCCESS)
+        {
+            return false;
+        }
+
+        if (!layout(fb, key.box, font, glyphs, nr_glyphs, quads))
+        {
+            /* The atlas is full, start over with only the glyphs of this text */
+            reset_atlas();
+            layout(fb, key.box, font, glyphs, nr_glyphs, quads);
+        }
+
+        cairo_glyph_free(glyphs);
+        return true;
+    }
+
+    /**
+     * Generate the quads for the given glyphs, cut to the box.
+     *
+     * @return false if not all glyphs could be stored in the atlas.
+     */
+    bool layout(const wf::framebuffer_t& fb, wf::geometry_t box, font_t& font,
+        const cairo_glyph_t *glyphs, int nr_glyphs, quads_t& quads)
+    {
+        quads.vertices.clear();
+        quads.uvs.clear();
+
+        /* Quads are placed on the pixel grid of the box, so that the glyphs are
+         * copied from the atlas without filtering */
+        const int max_x = std::round(box.width * fb.scale);
+        const int max_y = std::round(box.height * fb.scale);
+        const float texel = 1.0f / ATLAS_SIZE;
+
+        bool fits = true;
+        for (int i = 0; i < nr_glyphs; i++)
+        {
+            const glyph_t *glyph = get_glyph(font, glyphs[i].index);
+            if (!glyph)
+            {
+                fits = false;
+                continue;
+            }
+
+            int x1 = std::round(glyphs[i].x) + glyph->left;
+            int y1 = std::round(glyphs[i].y) + glyph->top;
+            if (x1 >= max_x)
+            {
+                break;
+            }
+
+            int x2 = std::min(x1 + glyph->width, max_x);
+            int y2 = std::min(y1 + glyph->height, max_y);
+            int u1 = glyph->x + std::max(0, -x1);
+            int v1 = glyph->y + std::max(0, -y1);
+            x1 = std::max(x1, 0);
+            y1 = std::max(y1, 0);
+            if ((x2 <= x1) || (y2 <= y1))
+            {
+                continue;
+            }
+
+            int u2 = u1 + (x2 - x1);
+            int v2 = v1 + (y2 - y1);
+
+            float left   = box.x + x1 / fb.scale;
+            float right  = box.x + x2 / fb.scale;
+            float top    = box.y + y1 / fb.scale;
+            float bottom = box.y + y2 / fb.scale;
+            quads.vertices.insert(quads.vertices.end(), {
+                left, top, right, top, right, bottom,
+                left, top, right, bottom, left, bottom,
+            });
+
+            float s1 = u1 * texel, s2 = u2 * texel;
+            float t1 = v1 * texel, t2 = v2 * texel;
+            quads.uvs.insert(quads.uvs.end(), {
+                s1, t1, s2, t1, s2, t2,
+                s1, t1, s2, t2, s1, t2,
+            });
+        }
+
+        return fits;
+    }
+};
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <cmath>
+#include <wayfire/nonstd/noncopyable.hpp>
+#include <wayfire/nonstd/reverse.hpp>
+#include <wayfire/object.hpp>
+#include <wayfire/output.hpp>
+#include <wayfire/opengl.hpp>
+#include <wayfire/view.hpp>
+#include <wayfire/signal-definitions.hpp>
+
+namespace wf
+{
+/**
+ * A cache of scaled-down images of the views on an output.
+ *
+ * Plugins which show many views at a reduced size, for ex. switcher, can
+ * draw the views from their thumbnails instead of rendering each view at
+ * full resolution on every frame. A thumbnail holds the view's surfaces
+ * without transformers. Once it is rendered, only the parts of the view
+ * which were damaged afterwards are rendered again.
+ *
+ * Using this interface allows all plugins on the output to share the same
+ * thumbnails. Thumbnails of views which are unmapped, minimized or leave the
+ * output are dropped.
+ */
+class view_thumbnail_cache_t : public noncopyable_t, public wf::custom_data_t
+{
+  public:
+    /**
+     * Make sure there is a thumbnail cache on the given output, and increase
+     * its reference count.
+     */
+    static nonstd::observer_ptr<view_thumbnail_cache_t> ensure_cache(
+        wf::output_t *output)
+    {
+        if (!output->has_data<view_thumbnail_cache_t>())
+        {
+            output->store_data(std::unique_ptr<view_thumbnail_cache_t>(
+                new view_thumbnail_cache_t(output)));
+        }
+
+        auto cache = output->get_data<view_thumbnail_cache_t>();
+        ++cache->ref_count;
+
+        return cache;
+    }
+
+    /**
+     * Decrease the reference count, and if no more references are being held,
+     * then destroy the cache.
+     */
+    void unref()
+    {
+        --ref_count;
+        if (ref_count == 0)
+        {
+            output->erase_data<view_thumbnail_cache_t>();
+        }
+    }
+
+    ~view_thumbnail_cache_t()
+    {
+        output->disconnect_signal("view-unmapped", &on_view_gone);
+        output->disconnect_signal("view-disappeared", &on_view_gone);
+        views.clear();
+    }
+
+    /**
+     * Get the thumbnail of a mapped view on the output, updated to the view's
+     * current contents.
+     *
+     * @param scale The size of the thumbnail relative to the view, at most 1.
+     *   It is rounded up to a multiple of 1/8, so that a view shown at a
+     *   slowly changing size does not need a new thumbnail on each frame.
+     *
+     * @return The framebuffer holding the thumbnail. Its geometry is the
+     *   view's untransformed bounding box, so it can be drawn like the view
+     *   itself, e.g by a transformer of the view.
+     */
+    const wf::framebuffer_t& get(wayfire_view view, float scale)
+    {
+        int steps = std::ceil(scale * SCALE_STEPS - 1e-3);
+        steps = std::min(std::max(steps, 1), SCALE_STEPS);
+
+        auto& entry = views[view];
+        if (!entry)
+        {
+            entry = std::make_unique<view_entry_t>(view);
+        }
+
+        auto& thumbnail = entry->get(steps);
+        update(view, thumbnail, 1.0 * steps / SCALE_STEPS);
+
+        return thumbnail.fb;
+    }
+
+  private:
+    /* Thumbnail scales are multiples of 1 / SCALE_STEPS */
+    static constexpr int SCALE_STEPS = 8;
+    /* Number of thumbnails at different scales kept for each view */
+    static constexpr size_t MAX_THUMBNAILS_PER_VIEW = 2;
+
+    struct thumbnail_t
+    {
+        wf::framebuffer_t fb;
+        /* Damage since the last update, relative to the view's bounding box */
+        wf::region_t damage;
+        /* Value of view_entry_t::use_counter when last used */
+        uint64_t last_use = 0;
+
+        ~thumbnail_t()
+        {
+            OpenGL::render_begin();
+            fb.release();
+            OpenGL::render_end();
+        }
+    };
+
+    struct view_entry_t
+    {
+        wayfire_view view;
+        /* Thumbnails by scale, in multiples of 1 / SCALE_STEPS */
+        std::map<int, thumbnail_t> thumbnails;
+        uint64_t use_counter = 0;
+
+        wf::signal_connection_t on_damage = [=] (wf::signal_data_t *data)
+        {
+            auto ev    = static_cast<wf::view_damaged_signal*>(data);
+            auto bbox  = view->get_untransformed_bounding_box();
+            auto local = ev->box;
+            local.x -= bbox.x;
+            local.y -= bbox.y;
+            for (auto& [steps, thumbnail] : thumbnails)
+            {
+                thumbnail.damage |= local;
+            }
+        };
+
+        view_entry_t(wayfire_view view)
+        {
+            this->view = view;
+            view->connect_signal("region-damaged", &on_damage);
+        }
+
+        thumbnail_t& get(int steps)
+        {
+            if (!thumbnails.count(steps) &&
+                (thumbnails.size() >= MAX_THUMBNAILS_PER_VIEW))
+            {
+                auto lru = thumbnails.begin();
+                for (auto it = thumbnails.begin(); it != thumbnails.end(); ++it)
+                {
+                    if (it->second.last_use < lru->second.last_use)
+                    {
+                        lru = it;
+                    }
+                }
+
+                thumbnails.erase(lru);
+            }
+
+            auto& thumbnail = thumbnails[steps];
+            thumbnail.last_use = ++use_counter;
+
+            return thumbnail;
+        }
+    };
+
+    /* Render the damaged parts of the thumbnail */
+    void update(wayfire_view view, thumbnail_t& thumbnail, float scale)
+    {
+        auto bbox = view->get_untransformed_bounding_box();
+        float fb_scale = output->handle->scale * scale;
+        int width  = std::max(1, (int)std::ceil(bbox.width * fb_scale));
+        int height = std::max(1, (int)std::ceil(bbox.height * fb_scale));
+
+        auto& fb = thumbnail.fb;
+        if ((width != fb.viewport_width) || (height != fb.viewport_height))
+        {
+            thumbnail.damage |= wf::geometry_t{0, 0, bbox.width, bbox.height};
+        }
+
+        fb.geometry = bbox;
+        fb.scale    = fb_scale;
+
+        thumbnail.damage &= wf::geometry_t{0, 0, bbox.width, bbox.height};
+        if (thumbnail.damage.empty())
+        {
+            return;
+        }
+
+        wf::region_t damage = thumbnail.damage + wf::point_t{bbox.x, bbox.y};
+        thumbnail.damage.clear();
+
+        OpenGL::render_begin();
+        fb.allocate(width, height);
+        fb.bind();
+        for (auto& box : damage)
+        {
+            fb.logic_scissor(wlr_box_from_pixman_box(box));
+            OpenGL::clear({0, 0, 0, 0});
+        }
+
+        OpenGL::render_end();
+
+        auto output_geometry = view->get_output_geometry();
+        auto children = view->enumerate_surfaces(
+            {output_geometry.x, output_geometry.y});
+        for (auto& child : wf::reverse(children))
+        {
+            wlr_box child_box{
+                child.position.x,
+                child.position.y,
+                child.surface->get_size().width,
+                child.surface->get_size().height
+            };
+
+            child.surface->simple_render(fb, child.position.x, child.position.y,
+                damage & child_box);
+        }
+    }
+
+    view_thumbnail_cache_t(wf::output_t *output)
+    {
+        this->output = output;
+        output->connect_signal("view-unmapped", &on_view_gone);
+        output->connect_signal("view-disappeared", &on_view_gone);
+    }
+
+    /* The view is still alive, but its thumbnails are no longer needed */
+    wf::signal_callback_t on_view_gone = [=] (wf::signal_data_t *data)
+    {
+        views.erase(get_signaled_view(data));
+    };
+
+    /** Number of active users of this instance */
+    uint32_t ref_count = 0;
+
+    wf::output_t *output;
+    std::map<wayfire_view, std::unique_ptr<view_entry_t>> views;
+};
+}
@@ -102,7 +102,7 @@ class workspace_wall_t : public wf::signal_provider_t
      */
     void render_wall(const wf::framebuffer_t& fb, wf::geometry_t geometry)
     {
-        update_streams();
+        update_streams(get_stream_scale(geometry));
 
         OpenGL::render_begin(fb);
         fb.logic_scissor(geometry);
@@ -204,14 +204,32 @@ class workspace_wall_t : public wf::signal_provider_t
     nonstd::observer_ptr<workspace_stream_pool_t> streams;
 
     /** Update or start visible streams */
-    void update_streams()
+    void update_streams(float scale)
     {
         for (auto& ws : get_visible_workspaces(viewport))
         {
-            streams->update(ws);
+            streams->update(ws, scale);
         }
     }
 
+    /**
+     * Calculate the scale at which workspaces are displayed when the viewport
+     * is rendered to the given box. The streams do not need a higher
+     * resolution than that.
+     */
+    float get_stream_scale(const wf::geometry_t& target) const
+    {
+        if ((viewport.width <= 0) || (viewport.height <= 0))
+        {
+            return 1.0;
+        }
+
+        double scale_x = target.width * 1.0 / viewport.width;
+        double scale_y = target.height * 1.0 / viewport.height;
+
+        return std::min(1.0, std::max(scale_x, scale_y));
+    }
+
     /**
      * Get a list of workspaces visible in the viewport.
      */
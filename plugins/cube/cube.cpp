@@ -49,7 +49,13 @@ class wayfire_cube : public wf::plugin_interface_t
      * for the given FOV */
     float identity_z_offset;
 
-    OpenGL::program_t program;
+    std::shared_ptr<OpenGL::program_t> program;
+    /* cached uniform and attribute handles of the program */
+    struct
+    {
+        OpenGL::program_t::attrib_t position, uv_position;
+        OpenGL::program_t::uniform_t vp, model, deform, light, ease;
+    } locs;
 
     wf_cube_animation_attribs animation;
     wf::option_wrapper_t<bool> use_light{"cube/light"};
@@ -188,8 +194,8 @@ class wayfire_cube : public wf::plugin_interface_t
 
         if (!tessellation_support)
         {
-            program.set_simple(OpenGL::compile_program(
-                cube_vertex_2_0, cube_fragment_2_0));
+            program = OpenGL::get_shared_simple_program(
+                cube_vertex_2_0, cube_fragment_2_0);
         } else
         {
 #ifdef USE_GLES32
@@ -216,10 +222,27 @@ class wayfire_cube : public wf::plugin_interface_t
             GL_CALL(glDeleteShader(tcs));
             GL_CALL(glDeleteShader(tes));
             GL_CALL(glDeleteShader(gss));
-            program.set_simple(id);
+            /* The tessellation program is specific to the output */
+            program = std::shared_ptr<OpenGL::program_t>(new OpenGL::program_t(),
+                [] (OpenGL::program_t *program)
+            {
+                OpenGL::render_begin();
+                program->free_resources();
+                OpenGL::render_end();
+                delete program;
+            });
+            program->set_simple(id);
 #endif
         }
 
+        locs.position    = program->get_attrib("position");
+        locs.uv_position = program->get_attrib("uvPosition");
+        locs.vp     = program->get_uniform("VP");
+        locs.model  = program->get_uniform("model");
+        locs.deform = program->get_uniform("deform");
+        locs.light  = program->get_uniform("light");
+        locs.ease   = program->get_uniform("ease");
+
         streams = wf::workspace_stream_pool_t::ensure_pool(output);
         animation.projection = glm::perspective(45.0f, 1.f, 0.1f, 100.f);
     }
@@ -480,7 +503,7 @@ class wayfire_cube : public wf::plugin_interface_t
                 streams->get({index, cws.y}).buffer.tex));
 
             auto model = calculate_model_matrix(i, fb_transform);
-            program.uniformMatrix4f("model", model);
+            program->uniformMatrix4f(locs.model, model);
 
             if (tessellation_support)
             {
@@ -498,7 +521,7 @@ class wayfire_cube : public wf::plugin_interface_t
     void render(const wf::framebuffer_t& dest)
     {
         update_workspace_streams();
-        if (program.get_program_id(wf::TEXTURE_TYPE_RGBA) == 0)
+        if (program->get_program_id(wf::TEXTURE_TYPE_RGBA) == 0)
         {
             load_program();
         }
@@ -513,7 +536,7 @@ class wayfire_cube : public wf::plugin_interface_t
         auto vp = calculate_vp_matrix(dest);
 
         OpenGL::render_begin(dest);
-        program.use(wf::TEXTURE_TYPE_RGBA);
+        program->use(wf::TEXTURE_TYPE_RGBA);
         GL_CALL(glEnable(GL_DEPTH_TEST));
         GL_CALL(glDepthFunc(GL_LESS));
 
@@ -531,14 +554,14 @@ class wayfire_cube : public wf::plugin_interface_t
             0.0f, 0.0f
         };
 
-        program.attrib_pointer("position", 2, 0, vertexData);
-        program.attrib_pointer("uvPosition", 2, 0, coordData);
-        program.uniformMatrix4f("VP", vp);
+        program->attrib_pointer(locs.position, 2, 0, vertexData);
+        program->attrib_pointer(locs.uv_position, 2, 0, coordData);
+        program->uniformMatrix4f(locs.vp, vp);
         if (tessellation_support)
         {
-            program.uniform1i("deform", use_deform);
-            program.uniform1i("light", use_light);
-            program.uniform1f("ease",
+            program->uniform1i(locs.deform, use_deform);
+            program->uniform1i(locs.light, use_light);
+            program->uniform1f(locs.ease,
                 animation.cube_animation.ease_deformation);
         }
 
@@ -552,7 +575,7 @@ class wayfire_cube : public wf::plugin_interface_t
         GL_CALL(glDisable(GL_CULL_FACE));
 
         GL_CALL(glDisable(GL_DEPTH_TEST));
-        program.deactivate();
+        program->deactivate();
         OpenGL::render_end();
 
         update_view_matrix();
@@ -635,9 +658,7 @@ class wayfire_cube : public wf::plugin_interface_t
 
         streams->unref();
 
-        OpenGL::render_begin();
-        program.free_resources();
-        OpenGL::render_end();
+        program.reset();
 
         output->rem_binding(&activate_binding);
         output->rem_binding(&rotate_left);
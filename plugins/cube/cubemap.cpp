@@ -15,16 +15,15 @@ wf_cube_background_cubemap::wf_cube_background_cubemap()
 
 wf_cube_background_cubemap::~wf_cube_background_cubemap()
 {
-    OpenGL::render_begin();
-    program.free_resources();
-    OpenGL::render_end();
+    program.reset();
 }
 
 void wf_cube_background_cubemap::create_program()
 {
     OpenGL::render_begin();
-    program.set_simple(
-        OpenGL::compile_program(cubemap_vertex, cubemap_fragment));
+    program = OpenGL::get_shared_simple_program(cubemap_vertex, cubemap_fragment);
+    position_loc = program->get_attrib("position");
+    matrix_loc   = program->get_uniform("cubeMapMatrix");
     OpenGL::render_end();
 }
 
@@ -93,11 +92,11 @@ void wf_cube_background_cubemap::render_frame(const wf::framebuffer_t& fb,
         return;
     }
 
-    program.use(wf::TEXTURE_TYPE_RGBA);
+    program->use(wf::TEXTURE_TYPE_RGBA);
     GL_CALL(glDepthMask(GL_FALSE));
 
     GL_CALL(glBindTexture(GL_TEXTURE_CUBE_MAP, tex));
-    program.attrib_pointer("position", 3, 0, skyboxVertices);
+    program->attrib_pointer(position_loc, 3, 0, skyboxVertices);
 
     auto model = glm::rotate(glm::mat4(1.0),
         float(attribs.cube_animation.rotation * 0.7f),
@@ -111,11 +110,11 @@ void wf_cube_background_cubemap::render_frame(const wf::framebuffer_t& fb,
     auto vp   = fb.transform * attribs.projection * view;
 
     model = vp * model;
-    program.uniformMatrix4f("cubeMapMatrix", model);
+    program->uniformMatrix4f(matrix_loc, model);
 
     GL_CALL(glDrawArrays(GL_TRIANGLES, 0, 6 * 6));
 
-    program.deactivate();
+    program->deactivate();
     GL_CALL(glDepthMask(GL_TRUE));
     OpenGL::render_end();
 }
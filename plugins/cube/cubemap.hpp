@@ -16,7 +16,9 @@ class wf_cube_background_cubemap : public wf_cube_background_base
     void reload_texture();
     void create_program();
 
-    OpenGL::program_t program;
+    std::shared_ptr<OpenGL::program_t> program;
+    OpenGL::program_t::attrib_t position_loc;
+    OpenGL::program_t::uniform_t matrix_loc;
     GLuint tex = -1;
 
     std::string last_background_image;
@@ -22,14 +22,19 @@ wf_cube_background_skydome::wf_cube_background_skydome(wf::output_t *output)
 wf_cube_background_skydome::~wf_cube_background_skydome()
 {
     OpenGL::render_begin();
-    program.deactivate();
+    program->deactivate();
     OpenGL::render_end();
 }
 
 void wf_cube_background_skydome::load_program()
 {
     OpenGL::render_begin();
-    program.set_simple(OpenGL::compile_program(cube_vertex_2_0, cube_fragment_2_0));
+    program = OpenGL::get_shared_simple_program(cube_vertex_2_0,
+        cube_fragment_2_0);
+    locs.position    = program->get_attrib("position");
+    locs.uv_position = program->get_attrib("uvPosition");
+    locs.vp    = program->get_uniform("VP");
+    locs.model = program->get_uniform("model");
     OpenGL::render_end();
 }
 
@@ -139,7 +144,7 @@ void wf_cube_background_skydome::render_frame(const wf::framebuffer_t& fb,
     }
 
     OpenGL::render_begin(fb);
-    program.use(wf::TEXTURE_TYPE_RGBA);
+    program->use(wf::TEXTURE_TYPE_RGBA);
 
     auto rotation = glm::rotate(glm::mat4(1.0),
         (float)(attribs.cube_animation.offset_y * 0.5),
@@ -150,17 +155,17 @@ void wf_cube_background_skydome::render_frame(const wf::framebuffer_t& fb,
         glm::vec3(0., 1., 0.));
 
     auto vp = fb.transform * attribs.projection * view * rotation;
-    program.uniformMatrix4f("VP", vp);
+    program->uniformMatrix4f(locs.vp, vp);
 
-    program.attrib_pointer("position", 3, 0, vertices.data());
-    program.attrib_pointer("uvPosition", 2, 0, coords.data());
+    program->attrib_pointer(locs.position, 3, 0, vertices.data());
+    program->attrib_pointer(locs.uv_position, 2, 0, coords.data());
 
     auto cws   = output->workspace->get_current_workspace();
     auto model = glm::rotate(glm::mat4(1.0),
         float(attribs.cube_animation.rotation) - cws.x * attribs.side_angle,
         glm::vec3(0, 1, 0));
 
-    program.uniformMatrix4f("model", model);
+    program->uniformMatrix4f(locs.model, model);
 
     GL_CALL(glActiveTexture(GL_TEXTURE0));
     GL_CALL(glBindTexture(GL_TEXTURE_2D, tex));
@@ -169,6 +174,6 @@ void wf_cube_background_skydome::render_frame(const wf::framebuffer_t& fb,
         6 * SKYDOME_GRID_WIDTH * (SKYDOME_GRID_HEIGHT - 2),
         GL_UNSIGNED_INT, indices.data()));
 
-    program.deactivate();
+    program->deactivate();
     OpenGL::render_end();
 }
@@ -21,7 +21,12 @@ class wf_cube_background_skydome : public wf_cube_background_base
     void fill_vertices();
     void reload_texture();
 
-    OpenGL::program_t program;
+    std::shared_ptr<OpenGL::program_t> program;
+    struct
+    {
+        OpenGL::program_t::attrib_t position, uv_position;
+        OpenGL::program_t::uniform_t vp, model;
+    } locs;
     GLuint tex = -1;
 
     std::vector<GLfloat> vertices;
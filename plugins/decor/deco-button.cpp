@@ -15,6 +15,14 @@ button_t::button_t(const decoration_theme_t& t, std::function<void()> damage) :
     theme(t), damage_callback(damage)
 {}
 
+button_t::~button_t()
+{
+    if (button_surface)
+    {
+        cairo_surface_destroy(button_surface);
+    }
+}
+
 void button_t::set_button_type(button_type_t type)
 {
     this->type = type;
@@ -93,11 +101,30 @@ void button_t::update_texture()
         .hover_progress = hover,
     };
 
-    auto surface = theme.get_button_surface(type, state);
+    /* The button is also damaged when it just needs to be redrawn */
+    if (button_surface && (rendered_type == type) &&
+        (rendered_hover == state.hover_progress))
+    {
+        return;
+    }
+
+    if (!button_surface)
+    {
+        button_surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+            state.width, state.height);
+    }
+
+    auto cr = cairo_create(button_surface);
+    theme.render_button(cr, type, state);
+    cairo_destroy(cr);
+
+    rendered_type  = type;
+    rendered_hover = state.hover_progress;
+
+    /* The storage of the texture is kept, since the size does not change */
     OpenGL::render_begin();
-    cairo_surface_upload_to_texture(surface, this->button_texture);
+    cairo_surface_upload_to_texture(button_surface, this->button_texture);
     OpenGL::render_end();
-    cairo_surface_destroy(surface);
 }
 
 void button_t::add_idle_damage()
@@ -36,6 +36,8 @@ class button_t : public noncopyable_t
     button_t(const decoration_theme_t& theme,
         std::function<void()> damage_callback);
 
+    ~button_t();
+
     /**
      * Set the type of the button. This will affect the displayed icon and
      * potentially other appearance like colors.
@@ -74,6 +76,11 @@ class button_t : public noncopyable_t
     /* Whether the button needs repaint */
     button_type_t type;
     wf::simple_texture_t button_texture;
+    /* The surface the button is drawn on, reused for each update */
+    cairo_surface_t *button_surface = nullptr;
+    /* The state the texture was last drawn with */
+    button_type_t rendered_type;
+    double rendered_hover = 0;
 
     /* Whether the button is currently being hovered */
     bool is_hovered = false;
@@ -14,8 +14,6 @@
 #include "deco-layout.hpp"
 #include "deco-theme.hpp"
 
-#include <wayfire/plugins/common/cairo-util.hpp>
-
 #include <cairo.h>
 
 extern "C"
@@ -43,33 +41,10 @@ class simple_decoration_surface : public wf::surface_interface_t,
         }
     };
 
-    void update_title(int width, int height, double scale)
-    {
-        int target_width  = width * scale;
-        int target_height = height * scale;
-
-        if ((title_texture.tex.width != target_width) ||
-            (title_texture.tex.height != target_height) ||
-            (title_texture.current_text != view->get_title()))
-        {
-            auto surface = theme.render_text(view->get_title(),
-                target_width, target_height);
-            cairo_surface_upload_to_texture(surface, title_texture.tex);
-            cairo_surface_destroy(surface);
-            title_texture.current_text = view->get_title();
-        }
-    }
-
     int width = 100, height = 100;
 
     bool active = true; // when views are mapped, they are usually activated
 
-    struct
-    {
-        wf::simple_texture_t tex;
-        std::string current_text = "";
-    } title_texture;
-
     wf::decor::decoration_theme_t theme;
     wf::decor::decoration_layout_t layout;
     wf::region_t cached_region;
@@ -111,9 +86,7 @@ class simple_decoration_surface : public wf::surface_interface_t,
     void render_title(const wf::framebuffer_t& fb,
         wf::geometry_t geometry)
     {
-        update_title(geometry.width, geometry.height, fb.scale);
-        OpenGL::render_texture(title_texture.tex.tex, fb, geometry,
-            glm::vec4(1.0f), OpenGL::TEXTURE_TRANSFORM_INVERT_Y);
+        theme.render_title(fb, geometry, view->get_title());
     }
 
     void render_scissor_box(const wf::framebuffer_t& fb, wf::point_t origin,
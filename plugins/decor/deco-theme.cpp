@@ -18,7 +18,14 @@ namespace decor
 {
 /** Create a new theme with the default parameters */
 decoration_theme_t::decoration_theme_t()
-{}
+{
+    text_renderer = wf::text_renderer_t::ensure_renderer();
+}
+
+decoration_theme_t::~decoration_theme_t()
+{
+    text_renderer->unref();
+}
 
 /** @return The available height for displaying the title */
 int decoration_theme_t::get_title_height() const
@@ -51,33 +58,19 @@ void decoration_theme_t::render_background(const wf::framebuffer_t& fb,
 }
 
 /**
- * Render the given text on a cairo_surface_t with the given size.
- * The caller is responsible for freeing the memory afterwards.
+ * Render the given text in the title box.
+ *
+ * @param fb The target framebuffer, must have been bound already.
+ * @param box The title box, the text is cut off at its edges.
+ * @param text The text to render.
  */
-cairo_surface_t*decoration_theme_t::render_text(std::string text,
-    int width, int height) const
+void decoration_theme_t::render_title(const wf::framebuffer_t& fb,
+    wf::geometry_t box, const std::string& text) const
 {
-    const auto format = CAIRO_FORMAT_ARGB32;
-    auto surface = cairo_image_surface_create(format, width, height);
-    auto cr = cairo_create(surface);
-
     const float font_scale = 0.8;
-    const float font_size  = height * font_scale;
-
-    // render text
-    cairo_select_font_face(cr, ((std::string)font).c_str(),
-        CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
-    cairo_set_source_rgba(cr, 1, 1, 1, 1);
-
-    cairo_set_font_size(cr, font_size);
-    cairo_move_to(cr, 0, font_size);
+    const float font_size  = box.height * font_scale;
 
-    cairo_text_extents_t ext;
-    cairo_text_extents(cr, text.c_str(), &ext);
-    cairo_show_text(cr, text.c_str());
-    cairo_destroy(cr);
-
-    return surface;
+    text_renderer->render(fb, box, text, font, font_size, {1, 1, 1, 1});
 }
 
 static struct icon_cache_t : public noncopyable_t
@@ -123,13 +116,11 @@ static struct icon_cache_t : public noncopyable_t
     }
 } cache;
 
-cairo_surface_t*decoration_theme_t::get_button_surface(button_type_t button,
+void decoration_theme_t::render_button(cairo_t *cr, button_type_t button,
     const button_state_t& state) const
 {
-    cairo_surface_t *button_icon    = cache.load_icon(button);
-    cairo_surface_t *button_surface = cairo_image_surface_create(
-        CAIRO_FORMAT_ARGB32, state.width, state.height);
-    auto cr = cairo_create(button_surface);
+    cairo_surface_t *button_icon = cache.load_icon(button);
+    cairo_save(cr);
 
     /* Clear the button background */
     cairo_rectangle(cr, 0, 0, state.width, state.height);
@@ -165,9 +156,7 @@ cairo_surface_t*decoration_theme_t::get_button_surface(button_type_t button,
     cairo_set_source_surface(cr, button_icon, 0, 0);
     cairo_fill(cr);
 
-    cairo_destroy(cr);
-
-    return button_surface;
+    cairo_restore(cr);
 }
 }
 }
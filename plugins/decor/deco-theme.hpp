@@ -1,5 +1,6 @@
 #pragma once
 #include <wayfire/render-manager.hpp>
+#include <wayfire/plugins/common/text-renderer.hpp>
 #include "deco-button.hpp"
 
 namespace wf
@@ -10,11 +11,12 @@ namespace decor
  * A  class which manages the outlook of decorations.
  * It is responsible for determining the background colors, sizes, etc.
  */
-class decoration_theme_t
+class decoration_theme_t : public noncopyable_t
 {
   public:
     /** Create a new theme with the default parameters */
     decoration_theme_t();
+    ~decoration_theme_t();
 
     /** @return The available height for displaying the title */
     int get_title_height() const;
@@ -33,10 +35,14 @@ class decoration_theme_t
         const wf::geometry_t& scissor, bool active) const;
 
     /**
-     * Render the given text on a cairo_surface_t with the given size.
-     * The caller is responsible for freeing the memory afterwards.
+     * Render the given text in the title box.
+     *
+     * @param fb The target framebuffer, must have been bound already.
+     * @param box The title box, the text is cut off at its edges.
+     * @param text The text to render.
      */
-    cairo_surface_t *render_text(std::string text, int width, int height) const;
+    void render_title(const wf::framebuffer_t& fb, wf::geometry_t box,
+        const std::string& text) const;
 
     struct button_state_t
     {
@@ -52,13 +58,14 @@ class decoration_theme_t
     };
 
     /**
-     * Get the icon for the given button.
-     * The caller is responsible for freeing the memory afterwards.
+     * Render the icon for the given button with the given cairo context.
+     * The whole state.width x state.height rectangle is overwritten.
      *
+     * @param cr The cairo context to render with.
      * @param button The button type.
      * @param state The button state.
      */
-    cairo_surface_t *get_button_surface(button_type_t button,
+    void render_button(cairo_t *cr, button_type_t button,
         const button_state_t& state) const;
 
   private:
@@ -67,6 +74,8 @@ class decoration_theme_t
     wf::option_wrapper_t<int> border_size{"decoration/border_size"};
     wf::option_wrapper_t<wf::color_t> active_color{"decoration/active_color"};
     wf::option_wrapper_t<wf::color_t> inactive_color{"decoration/inactive_color"};
+
+    nonstd::observer_ptr<wf::text_renderer_t> text_renderer;
 };
 }
 }
@@ -1,4 +1,5 @@
-#include <wayfire/singleton-plugin.hpp>
+#include <wayfire/per-output-plugin.hpp>
+#include <wayfire/core.hpp>
 #include <wayfire/view.hpp>
 #include <wayfire/matcher.hpp>
 #include <wayfire/workspace-manager.hpp>
@@ -7,20 +8,11 @@
 
 #include "deco-subsurface.hpp"
 
-struct wayfire_decoration_global_cleanup_t
-{
-    ~wayfire_decoration_global_cleanup_t()
-    {
-        for (auto view : wf::get_core().get_all_views())
-        {
-            deinit_view(view);
-        }
-    }
-};
-
-class wayfire_decoration :
-    public wf::singleton_plugin_t<wayfire_decoration_global_cleanup_t, true>
+/** Decorates the views on a single output */
+class wayfire_decoration_output_t
 {
+    wf::output_t *output;
+    wf::plugin_grab_interface_uptr grab_interface;
     wf::view_matcher_t ignore_views{"decoration/ignore_views"};
 
     wf::signal_connection_t view_updated{
@@ -31,9 +23,10 @@ class wayfire_decoration :
     };
 
   public:
-    void init() override
+    wayfire_decoration_output_t(wf::output_t *output)
     {
-        singleton_plugin_t::init();
+        this->output   = output;
+        grab_interface = std::make_unique<wf::plugin_grab_interface_t>(output);
         grab_interface->name = "simple-decoration";
         grab_interface->capabilities = wf::CAPABILITY_VIEW_DECORATOR;
 
@@ -72,14 +65,30 @@ class wayfire_decoration :
         }
     }
 
-    void fini() override
+    ~wayfire_decoration_output_t()
     {
         for (auto& view : output->workspace->get_views_in_layer(wf::ALL_LAYERS))
         {
             deinit_view(view);
         }
 
-        singleton_plugin_t::fini();
+        output->deactivate_plugin(grab_interface);
+    }
+};
+
+class wayfire_decoration :
+    public wf::per_output_plugin_t<wayfire_decoration_output_t>
+{
+  public:
+    void fini() override
+    {
+        per_output_plugin_t::fini();
+
+        /* Views may have moved to outputs where the plugin is not enabled */
+        for (auto view : wf::get_core().get_all_views())
+        {
+            deinit_view(view);
+        }
     }
 };
 
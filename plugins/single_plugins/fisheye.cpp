@@ -23,6 +23,7 @@
  */
 
 #include <wayfire/plugin.hpp>
+#include <wayfire/core.hpp>
 #include <wayfire/output.hpp>
 #include <wayfire/opengl.hpp>
 #include <wayfire/util/duration.hpp>
@@ -102,6 +103,8 @@ class wayfire_fisheye : public wf::plugin_interface_t
 
     float target_zoom;
     bool active, hook_set;
+    /* Whether the cursor moved since the last frame */
+    bool cursor_moved = false;
 
     wf::option_wrapper_t<double> radius{"fisheye/radius"};
     wf::option_wrapper_t<double> zoom{"fisheye/zoom"};
@@ -125,6 +128,7 @@ class wayfire_fisheye : public wf::plugin_interface_t
             if (active)
             {
                 this->progression.animate(zoom);
+                output->render->schedule_redraw();
             }
         });
 
@@ -145,6 +149,7 @@ class wayfire_fisheye : public wf::plugin_interface_t
         {
             active = false;
             progression.animate(0);
+            output->render->schedule_redraw();
         } else
         {
             active = true;
@@ -153,7 +158,13 @@ class wayfire_fisheye : public wf::plugin_interface_t
             {
                 hook_set = true;
                 output->render->add_post(&render_hook);
-                output->render->set_redraw_always();
+                output->render->add_animation_driver(&animation);
+                wf::get_core().connect_signal("pointer_motion", &on_motion);
+                wf::get_core().connect_signal("pointer_motion_absolute",
+                    &on_motion);
+            } else
+            {
+                output->render->schedule_redraw();
             }
         }
 
@@ -201,10 +212,27 @@ class wayfire_fisheye : public wf::plugin_interface_t
         }
     };
 
+    /* The lens follows the cursor, so it needs a new frame when the cursor
+     * moves, even though nothing is damaged */
+    wf::signal_connection_t on_motion = [=] (wf::signal_data_t*)
+    {
+        cursor_moved = true;
+        output->render->schedule_redraw();
+    };
+
+    wf::animation_driver_t animation = [=] ()
+    {
+        bool needs_frame = progression.running() || cursor_moved;
+        cursor_moved = false;
+
+        return needs_frame;
+    };
+
     void finalize()
     {
         output->render->rem_post(&render_hook);
-        output->render->set_redraw_always(false);
+        output->render->rem_animation_driver(&animation);
+        on_motion.disconnect();
         hook_set = false;
     }
 
@@ -27,6 +27,7 @@ class wayfire_grid_view_cdata : public wf::custom_data_t
     wayfire_view view;
     wf::output_t *output;
     wf::effect_hook_t pre_hook;
+    wf::animation_driver_t animation_driver;
     wf::signal_callback_t unmapped;
 
     int32_t tiled_edges = -1;
@@ -60,6 +61,12 @@ class wayfire_grid_view_cdata : public wf::custom_data_t
         };
         output->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE);
 
+        animation_driver = [=] ()
+        {
+            return animation.running();
+        };
+        output->render->add_animation_driver(&animation_driver);
+
         unmapped = [=] (wf::signal_data_t *data)
         {
             if (get_signaled_view(data) == view)
@@ -68,7 +75,6 @@ class wayfire_grid_view_cdata : public wf::custom_data_t
             }
         };
 
-        output->render->set_redraw_always(true);
         output->connect_signal("view-disappeared", &unmapped);
     }
 
@@ -120,6 +126,7 @@ class wayfire_grid_view_cdata : public wf::custom_data_t
         view->set_moving(1);
         view->set_resizing(1);
         animation.start();
+        output->render->schedule_redraw();
     }
 
     void set_end_state(wf::geometry_t geometry, int32_t edges)
@@ -154,8 +161,8 @@ class wayfire_grid_view_cdata : public wf::custom_data_t
         }
 
         output->render->rem_effect(&pre_hook);
+        output->render->rem_animation_driver(&animation_driver);
         output->deactivate_plugin(iface);
-        output->render->set_redraw_always(false);
         output->disconnect_signal("view-disappeared", &unmapped);
     }
 };
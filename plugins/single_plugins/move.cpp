@@ -278,7 +278,6 @@ class wayfire_move : public wf::plugin_interface_t
         }
 
         this->view = view;
-        output->render->set_redraw_always();
         update_multi_output();
 
         return true;
@@ -288,7 +287,6 @@ class wayfire_move : public wf::plugin_interface_t
     {
         grab_interface->ungrab();
         output->deactivate_plugin(grab_interface);
-        output->render->set_redraw_always(false);
     }
 
     void input_pressed(uint32_t state, bool view_destroyed)
@@ -12,6 +12,7 @@
 
 #include <wayfire/util/duration.hpp>
 #include <wayfire/nonstd/reverse.hpp>
+#include <wayfire/plugins/common/view-thumbnail-cache.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <algorithm>
@@ -99,6 +100,9 @@ class WayfireSwitcher : public wf::plugin_interface_t
     /* If a view comes before another in this list, it is on top of it */
     std::vector<SwitcherView> views;
 
+    /* Thumbnails of the switched views, held while switcher is active */
+    nonstd::observer_ptr<wf::view_thumbnail_cache_t> thumbnails;
+
     // the modifiers which were used to activate switcher
     uint32_t activating_modifiers = 0;
     bool active = false;
@@ -182,9 +186,22 @@ class WayfireSwitcher : public wf::plugin_interface_t
         return true;
     };
 
-    wf::effect_hook_t damage = [=] ()
+    /* Whether the animations were running in the previous frame */
+    bool was_animating = false;
+    wf::animation_driver_t animation = [=] ()
     {
-        output->render->damage_whole();
+        /* Views are shown at more than one place, so their own damage does
+         * not cover them. Damage the whole output while animating, and once
+         * more when the animations end, to show their final state. */
+        bool animating = duration.running() || background_dim_duration.running();
+        if (animating || was_animating)
+        {
+            output->render->damage_whole();
+        }
+
+        was_animating = animating;
+
+        return animating;
     };
 
     wf::signal_callback_t view_removed = [=] (wf::signal_data_t *data)
@@ -305,9 +322,9 @@ class WayfireSwitcher : public wf::plugin_interface_t
             return false;
         }
 
-        output->render->add_effect(&damage, wf::OUTPUT_EFFECT_PRE);
         output->render->set_renderer(switcher_renderer);
-        output->render->set_redraw_always();
+        output->render->add_animation_driver(&animation);
+        thumbnails = wf::view_thumbnail_cache_t::ensure_cache(output);
 
         return true;
     }
@@ -317,9 +334,8 @@ class WayfireSwitcher : public wf::plugin_interface_t
     {
         output->deactivate_plugin(grab_interface);
 
-        output->render->rem_effect(&damage);
         output->render->set_renderer(nullptr);
-        output->render->set_redraw_always(false);
+        output->render->rem_animation_driver(&animation);
 
         for (auto& view : output->workspace->get_views_in_layer(wf::ALL_LAYERS))
         {
@@ -328,6 +344,12 @@ class WayfireSwitcher : public wf::plugin_interface_t
         }
 
         views.clear();
+
+        if (thumbnails)
+        {
+            thumbnails->unref();
+            thumbnails = nullptr;
+        }
     }
 
     /* offset from the left or from the right */
@@ -502,6 +524,7 @@ class WayfireSwitcher : public wf::plugin_interface_t
         duration.start();
         background_dim.set(1, background_dim_factor);
         background_dim_duration.start();
+        output->render->schedule_redraw();
 
         auto ws_views = get_workspace_views();
         for (auto v : ws_views)
@@ -565,6 +588,7 @@ class WayfireSwitcher : public wf::plugin_interface_t
         background_dim.restart_with_end(1);
         background_dim_duration.start();
         duration.start();
+        output->render->schedule_redraw();
         active = false;
 
         /* Potentially restore view[0] if it was maximized */
@@ -645,7 +669,21 @@ class WayfireSwitcher : public wf::plugin_interface_t
             (float)sv.attribs.rotation, {0.0, 1.0, 0.0});
 
         transform->color[3] = sv.attribs.alpha;
-        sv.view->render_transformed(buffer, buffer.geometry);
+
+        /* If the switcher transformer is the only one, draw the view from a
+         * thumbnail at the size it is shown at, instead of rendering it at
+         * full resolution */
+        if (sv.view->is_mapped() && (sv.view->get_transformer_count() == 1))
+        {
+            float scale = std::max((float)sv.attribs.scale_x,
+                (float)sv.attribs.scale_y);
+            auto& thumbnail = thumbnails->get(sv.view, scale);
+            transform->render_with_damage(wf::texture_t{thumbnail.tex},
+                thumbnail.geometry, buffer.geometry, buffer);
+        } else
+        {
+            sv.view->render_transformed(buffer, buffer.geometry);
+        }
     }
 
     wf::render_hook_t switcher_renderer = [=] (const wf::framebuffer_t& fb)
@@ -788,6 +826,7 @@ class WayfireSwitcher : public wf::plugin_interface_t
         rebuild_view_list();
         output->workspace->bring_to_front(views.front().view);
         duration.start();
+        output->render->schedule_redraw();
     }
 
     int count_different_active_views()
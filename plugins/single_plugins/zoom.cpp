@@ -1,4 +1,5 @@
 #include <wayfire/plugin.hpp>
+#include <wayfire/core.hpp>
 #include <wayfire/output.hpp>
 #include <wayfire/opengl.hpp>
 #include <wayfire/render-manager.hpp>
@@ -11,6 +12,8 @@ class wayfire_zoom_screen : public wf::plugin_interface_t
     wf::option_wrapper_t<int> smoothing_duration{"zoom/smoothing_duration"};
     wf::animation::simple_animation_t progression{smoothing_duration};
     bool hook_set = false;
+    /* Whether the cursor moved since the last frame */
+    bool cursor_moved = false;
 
   public:
     void init() override
@@ -37,7 +40,13 @@ class wayfire_zoom_screen : public wf::plugin_interface_t
             {
                 hook_set = true;
                 output->render->add_post(&render_hook);
-                output->render->set_redraw_always();
+                output->render->add_animation_driver(&animation);
+                wf::get_core().connect_signal("pointer_motion", &on_motion);
+                wf::get_core().connect_signal("pointer_motion_absolute",
+                    &on_motion);
+            } else
+            {
+                output->render->schedule_redraw();
             }
         }
     }
@@ -96,10 +105,27 @@ class wayfire_zoom_screen : public wf::plugin_interface_t
         }
     };
 
+    /* The zoomed area follows the cursor, so it needs a new frame when the
+     * cursor moves, even though nothing is damaged */
+    wf::signal_connection_t on_motion = [=] (wf::signal_data_t*)
+    {
+        cursor_moved = true;
+        output->render->schedule_redraw();
+    };
+
+    wf::animation_driver_t animation = [=] ()
+    {
+        bool needs_frame = progression.running() || cursor_moved;
+        cursor_moved = false;
+
+        return needs_frame;
+    };
+
     void unset_hook()
     {
-        output->render->set_redraw_always(false);
+        output->render->rem_animation_driver(&animation);
         output->render->rem_post(&render_hook);
+        on_motion.disconnect();
         hook_set = false;
     }
 
@@ -107,7 +133,7 @@ class wayfire_zoom_screen : public wf::plugin_interface_t
     {
         if (hook_set)
         {
-            output->render->rem_post(&render_hook);
+            unset_hook();
         }
 
         output->rem_binding(&axis);
@@ -37,47 +37,42 @@
 
 #include "wobbly.h"
 
-#define GRID_WIDTH  4
-#define GRID_HEIGHT 4
-
-#define MODEL_MAX_SPRINGS (GRID_WIDTH * GRID_HEIGHT * 2)
+/* Number of pixels covered by one cell of the spring grid, when the grid is
+ * allowed to grow beyond WOBBLY_MIN_GRID objects per side */
+#define GRID_SPACING 256
 
 typedef struct _xy_pair {
     float x, y;
 } Point, Vector;
 
-typedef struct _Edge {
-    float next, prev;
-
-    float start;
-    float end;
-
-    float attract;
-    float velocity;
-} Edge;
+/*
+ * The model is a grid of gridWidth x gridHeight objects, connected by springs
+ * to their horizontal and vertical neighbours. All springs in one direction
+ * have the same rest length, so they are not stored explicitly.
+ *
+ * Object data is kept as one array per component, so that the simulation
+ * runs over contiguous floats in branch-free loops. The rows of a single
+ * model are too short to vectorize well, so models with the same grid size
+ * are stepped together by modelStepGroup, which vectorizes across models.
+ */
+typedef struct _Model {
+    int		 gridWidth;
+    int		 gridHeight;
+    int		 numObjects;
 
-typedef struct _Object {
-    Vector	 force;
-    Point	 position;
-    Vector	 velocity;
-    float	 theta;
-    int		 immobile;
-    Edge	 vertEdge;
-    Edge	 horzEdge;
-} Object;
+    float	 *positionX, *positionY;
+    float	 *velocityX, *velocityY;
+    float	 *forceX, *forceY;
+    /* 1.0 for objects which move, 0.0 for immobile objects */
+    float	 *mobile;
+    /* Forces of the horizontal springs in a row, scratch space for modelStep */
+    float	 *springX, *springY;
 
-typedef struct _Spring {
-    Object *a;
-    Object *b;
-    Vector offset;
-} Spring;
+    /* Rest length of the horizontal and vertical springs */
+    float	 hpad, vpad;
 
-typedef struct _Model {
-    Object	 *objects;
-    int		 numObjects;
-    Spring	 springs[MODEL_MAX_SPRINGS];
-    int		 numSprings;
-    Object	 *anchorObject;
+    /* Index of the anchor object, -1 if there is none */
+    int		 anchorObject;
     float	 steps;
     Point	 topLeft;
     Point	 bottomRight;
@@ -97,102 +92,75 @@ typedef struct _WobblyWindow {
 #define WobblyForce    (1L << 1)
 #define WobblyVelocity (1L << 2)
 
-static void objectInit(Object *object, float positionX, float positionY,
-        float velocityX, float velocityY)
+static int objectIsImmobile(Model *model, int object)
 {
-    object->force.x = 0;
-    object->force.y = 0;
-
-    object->position.x = positionX;
-    object->position.y = positionY;
-
-    object->velocity.x = velocityX;
-    object->velocity.y = velocityY;
-
-    object->theta    = 0;
-    object->immobile = 0;
-
-    object->vertEdge.next = 0.0f;
-    object->horzEdge.next = 0.0f;
+    return model->mobile[object] == 0.0f;
 }
 
-static void springInit(Spring *spring, Object *a, Object *b,
-	    float offsetX, float offsetY)
+static void objectSetImmobile(Model *model, int object, int immobile)
 {
-    spring->a	     = a;
-    spring->b	     = b;
-    spring->offset.x = offsetX;
-    spring->offset.y = offsetY;
+    model->mobile[object] = immobile ? 0.0f : 1.0f;
 }
 
 static void modelCalcBounds(Model *model)
 {
+    const float *px = model->positionX;
+    const float *py = model->positionY;
+    float minX = px[0], maxX = px[0];
+    float minY = py[0], maxY = py[0];
     int i;
 
-    model->topLeft.x	 = SHRT_MAX;
-    model->topLeft.y	 = SHRT_MAX;
-    model->bottomRight.x = SHRT_MIN;
-    model->bottomRight.y = SHRT_MIN;
-
-    for (i = 0; i < model->numObjects; i++)
+    for (i = 1; i < model->numObjects; i++)
     {
-        if (model->objects[i].position.x < model->topLeft.x)
-            model->topLeft.x = model->objects[i].position.x;
-        else if (model->objects[i].position.x > model->bottomRight.x)
-            model->bottomRight.x = model->objects[i].position.x;
-
-        if (model->objects[i].position.y < model->topLeft.y)
-            model->topLeft.y = model->objects[i].position.y;
-        else if (model->objects[i].position.y > model->bottomRight.y)
-            model->bottomRight.y = model->objects[i].position.y;
+        minX = px[i] < minX ? px[i] : minX;
+        maxX = px[i] > maxX ? px[i] : maxX;
+        minY = py[i] < minY ? py[i] : minY;
+        maxY = py[i] > maxY ? py[i] : maxY;
     }
-}
 
-static void modelAddSpring(Model *model, Object *a, Object *b,
-		float offsetX, float offsetY)
-{
-    Spring *spring;
-
-    spring = &model->springs[model->numSprings];
-    model->numSprings++;
-
-    springInit (spring, a, b, offsetX, offsetY);
+    model->topLeft.x     = minX;
+    model->topLeft.y     = minY;
+    model->bottomRight.x = maxX;
+    model->bottomRight.y = maxY;
 }
 
 static void modelSetMiddleAnchor(Model *model, int x, int y,
         int width, int height)
 {
+    int gridWidth  = model->gridWidth;
+    int gridHeight = model->gridHeight;
     float gx, gy;
 
-    gx = ((GRID_WIDTH  - 1) / 2 * width)  / (float) (GRID_WIDTH  - 1);
-    gy = ((GRID_HEIGHT - 1) / 2 * height) / (float) (GRID_HEIGHT - 1);
+    gx = ((gridWidth  - 1) / 2 * width)  / (float) (gridWidth  - 1);
+    gy = ((gridHeight - 1) / 2 * height) / (float) (gridHeight - 1);
 
-    if (model->anchorObject)
-        model->anchorObject->immobile = 0;
+    if (model->anchorObject >= 0)
+        objectSetImmobile(model, model->anchorObject, 0);
 
     model->anchorObject =
-        &model->objects[GRID_WIDTH * ((GRID_HEIGHT-1)/2) + (GRID_WIDTH-1)/ 2];
-    model->anchorObject->position.x = x + gx;
-    model->anchorObject->position.y = y + gy;
+        gridWidth * ((gridHeight - 1) / 2) + (gridWidth - 1) / 2;
+    model->positionX[model->anchorObject] = x + gx;
+    model->positionY[model->anchorObject] = y + gy;
 
-    model->anchorObject->immobile = 1;
+    objectSetImmobile(model, model->anchorObject, 1);
 }
 
 static void modelSetTopAnchor(Model *model, int x, int y,
         int width)
 {
+    int gridWidth = model->gridWidth;
     float gx;
 
-    gx = ((GRID_WIDTH  - 1) / 2 * width)  / (float) (GRID_WIDTH  - 1);
+    gx = ((gridWidth - 1) / 2 * width) / (float) (gridWidth - 1);
 
-    if (model->anchorObject)
-	model->anchorObject->immobile = 0;
+    if (model->anchorObject >= 0)
+        objectSetImmobile(model, model->anchorObject, 0);
 
-    model->anchorObject = &model->objects[(GRID_WIDTH-1)/ 2];
-    model->anchorObject->position.x = x + gx;
-    model->anchorObject->position.y = y;
+    model->anchorObject = (gridWidth - 1) / 2;
+    model->positionX[model->anchorObject] = x + gx;
+    model->positionY[model->anchorObject] = y;
 
-    model->anchorObject->immobile = 1;
+    objectSetImmobile(model, model->anchorObject, 1);
 }
 
 static void modelInitObjects(Model *model, int x, int y, int width, int height)
@@ -200,75 +168,88 @@ static void modelInitObjects(Model *model, int x, int y, int width, int height)
     int	  gridX, gridY, i = 0;
     float gw, gh;
 
-    gw = GRID_WIDTH  - 1;
-    gh = GRID_HEIGHT - 1;
+    gw = model->gridWidth  - 1;
+    gh = model->gridHeight - 1;
 
-    for (gridY = 0; gridY < GRID_HEIGHT; gridY++)
+    for (gridY = 0; gridY < model->gridHeight; gridY++)
     {
-        for (gridX = 0; gridX < GRID_WIDTH; gridX++)
+        for (gridX = 0; gridX < model->gridWidth; gridX++)
         {
-            objectInit (&model->objects[i],
-                    x + (gridX * width) / gw,
-                    y + (gridY * height) / gh,
-                    0, 0);
+            model->positionX[i] = x + (gridX * width) / gw;
+            model->positionY[i] = y + (gridY * height) / gh;
+            model->velocityX[i] = 0;
+            model->velocityY[i] = 0;
+            model->forceX[i] = 0;
+            model->forceY[i] = 0;
+            model->mobile[i] = 1.0f;
             i++;
         }
     }
 
-    if (!model->anchorObject)
+    if (model->anchorObject < 0)
         modelSetMiddleAnchor (model, x, y, width, height);
 }
 
 static void modelInitSprings(Model *model, int width, int height)
 {
-    int   gridX, gridY, i = 0;
-    float hpad, vpad;
-
-    model->numSprings = 0;
-
-    hpad = ((float) width) / (GRID_WIDTH  - 1);
-    vpad = ((float) height) / (GRID_HEIGHT - 1);
+    model->hpad = ((float) width) / (model->gridWidth  - 1);
+    model->vpad = ((float) height) / (model->gridHeight - 1);
+}
 
-    for (gridY = 0; gridY < GRID_HEIGHT; gridY++)
-    {
-        for (gridX = 0; gridX < GRID_WIDTH; gridX++)
-        {
-            if (gridX > 0)
-            {
-                modelAddSpring (model, &model->objects[i - 1],
-                        &model->objects[i], hpad, 0);
-            }
+/* Number of objects along a side of the given length */
+static int gridSizeFor(int length)
+{
+    int maxSize = wobbly_settings_get_max_grid();
+    int size = 1 + (length + GRID_SPACING - 1) / GRID_SPACING;
 
-            if (gridY > 0)
-            {
-                modelAddSpring (model, &model->objects[i - GRID_WIDTH],
-                        &model->objects[i], 0, vpad);
-            }
+    if (size > maxSize)
+        size = maxSize;
+    if (size < WOBBLY_MIN_GRID)
+        size = WOBBLY_MIN_GRID;
 
-            i++;
-        }
-    }
+    return size;
 }
 
+/* Number of live models, the scratch space of modelStepGroup is released
+ * once there are none left */
+static int liveModels;
+static void groupRelease(void);
+
 static Model * createModel(int x, int y, int width, int height)
 {
     Model *model;
+    float *data;
+    int n;
 
     model = malloc(sizeof(Model));
     if (!model)
         return 0;
 
-    model->numObjects = GRID_WIDTH * GRID_HEIGHT;
-    model->objects = malloc (sizeof (Object) * model->numObjects);
-    if (!model->objects)
+    model->gridWidth  = gridSizeFor(width);
+    model->gridHeight = gridSizeFor(height);
+    model->numObjects = n = model->gridWidth * model->gridHeight;
+
+    /* All object arrays share a single allocation */
+    data = calloc(9 * n, sizeof(float));
+    if (!data)
     {
         free (model);
         return 0;
     }
 
-    model->anchorObject = 0;
-    model->numSprings = 0;
+    model->positionX = data;
+    model->positionY = data + n;
+    model->velocityX = data + 2 * n;
+    model->velocityY = data + 3 * n;
+    model->forceX    = data + 4 * n;
+    model->forceY    = data + 5 * n;
+    model->mobile    = data + 6 * n;
+    model->springX   = data + 7 * n;
+    model->springY   = data + 8 * n;
+
+    model->anchorObject = -1;
     model->steps = 0;
+    liveModels++;
 
     modelInitObjects (model, x, y, width, height);
     modelInitSprings (model, width, height);
@@ -277,90 +258,125 @@ static Model * createModel(int x, int y, int width, int height)
     return model;
 }
 
-static void objectApplyForce(Object *object, float fx, float fy)
+static void destroyModel(Model *model)
 {
-    object->force.x += fx;
-    object->force.y += fy;
+    free(model->positionX);
+    free(model);
+
+    if (--liveModels == 0)
+        groupRelease();
 }
 
-static void springExertForces(Spring *spring, float k)
+static void modelExertSpringForces(Model *model, float k)
 {
-    Vector da, db;
-    Vector a, b;
+    int gridWidth = model->gridWidth;
+    float *restrict fx = model->forceX;
+    float *restrict fy = model->forceY;
+    float *restrict sx = model->springX;
+    float *restrict sy = model->springY;
+    const float *restrict px = model->positionX;
+    const float *restrict py = model->positionY;
+    float hk = 0.5f * k;
+    float hpad = model->hpad, vpad = model->vpad;
+    int x, y, row;
+
+    /* Horizontal springs, between objects row + x and row + x + 1 */
+    for (y = 0; y < model->gridHeight; y++)
+    {
+        row = y * gridWidth;
+        for (x = 0; x < gridWidth - 1; x++)
+        {
+            sx[x] = hk * (px[row + x + 1] - px[row + x] - hpad);
+            sy[x] = hk * (py[row + x + 1] - py[row + x]);
+        }
 
-    a = spring->a->position;
-    b = spring->b->position;
+        for (x = 0; x < gridWidth - 1; x++)
+        {
+            fx[row + x] += sx[x];
+            fy[row + x] += sy[x];
+        }
 
-    da.x = 0.5f * (b.x - a.x - spring->offset.x);
-    da.y = 0.5f * (b.y - a.y - spring->offset.y);
+        for (x = 1; x < gridWidth; x++)
+        {
+            fx[row + x] -= sx[x - 1];
+            fy[row + x] -= sy[x - 1];
+        }
+    }
 
-    db.x = 0.5f * (a.x - b.x + spring->offset.x);
-    db.y = 0.5f * (a.y - b.y + spring->offset.y);
+    /* Vertical springs, between objects row - gridWidth + x and row + x */
+    for (y = 1; y < model->gridHeight; y++)
+    {
+        row = y * gridWidth;
+        for (x = 0; x < gridWidth; x++)
+        {
+            float dx = hk * (px[row + x] - px[row - gridWidth + x]);
+            float dy = hk * (py[row + x] - py[row - gridWidth + x] - vpad);
 
-    objectApplyForce (spring->a, k * da.x, k * da.y);
-    objectApplyForce (spring->b, k * db.x, k * db.y);
+            fx[row - gridWidth + x] += dx;
+            fy[row - gridWidth + x] += dy;
+            fx[row + x] -= dx;
+            fy[row + x] -= dy;
+        }
+    }
 }
 
-static float modelStepObject(Object *object, float friction, float *force)
+/* Move all objects according to the accumulated forces. Immobile objects
+ * are masked out instead of branched on. */
+static void modelStepObjects(Model *model, float friction,
+        float *velocitySum, float *forceSum)
 {
-    object->theta += 0.05f;
-
-    if (object->immobile)
-    {
-        object->velocity.x = 0.0f;
-        object->velocity.y = 0.0f;
-        object->force.x = 0.0f;
-        object->force.y = 0.0f;
+    float *restrict px = model->positionX;
+    float *restrict py = model->positionY;
+    float *restrict vx = model->velocityX;
+    float *restrict vy = model->velocityY;
+    float *restrict fx = model->forceX;
+    float *restrict fy = model->forceY;
+    const float *restrict mobile = model->mobile;
+    float velocity = 0.0f, force = 0.0f;
+    int i;
 
-        *force = 0.0f;
-        return 0.0f;
-    }
-    else
+    for (i = 0; i < model->numObjects; i++)
     {
-        object->force.x -= friction * object->velocity.x;
-        object->force.y -= friction * object->velocity.y;
+        float forceX = fx[i] - friction * vx[i];
+        float forceY = fy[i] - friction * vy[i];
 
-        object->velocity.x += object->force.x / WOBBLY_MASS;
-        object->velocity.y += object->force.y / WOBBLY_MASS;
+        vx[i] = mobile[i] * (vx[i] + forceX / WOBBLY_MASS);
+        vy[i] = mobile[i] * (vy[i] + forceY / WOBBLY_MASS);
 
-        object->position.x += object->velocity.x;
-        object->position.y += object->velocity.y;
+        /* Avoid denormals, see laneFlushTiny */
+        vx[i] = fabsf(vx[i]) > 1e-20f ? vx[i] : 0.0f;
+        vy[i] = fabsf(vy[i]) > 1e-20f ? vy[i] : 0.0f;
 
-        *force = fabs(object->force.x) + fabs(object->force.y);
+        px[i] += vx[i];
+        py[i] += vy[i];
 
-        object->force.x = 0.0f;
-        object->force.y = 0.0f;
+        force += mobile[i] * (fabsf(forceX) + fabsf(forceY));
+        velocity += fabsf(vx[i]) + fabsf(vy[i]);
 
-        return fabs(object->velocity.x) + fabs(object->velocity.y);
+        fx[i] = 0.0f;
+        fy[i] = 0.0f;
     }
+
+    *velocitySum += velocity;
+    *forceSum += force;
 }
 
-static int modelStep(Model *model, float friction, float k, float time)
+/* Advance the step accumulator of the model by the given time, returning the
+ * number of whole simulation steps to run */
+static int modelTakeSteps(Model *model, float time)
 {
-    int   i, j, steps, wobbly = 0;
-    float velocitySum = 0.0f;
-    float force, forceSum = 0.0f;
+    int steps;
 
     model->steps += time / 15.0f;
     steps = floor (model->steps);
     model->steps -= steps;
 
-    if (!steps)
-        return 1;
-
-    for (j = 0; j < steps; j++)
-    {
-        for (i = 0; i < model->numSprings; i++)
-            springExertForces (&model->springs[i], k);
-
-        for (i = 0; i < model->numObjects; i++)
-        {
-            velocitySum += modelStepObject(&model->objects[i], friction, &force);
-            forceSum += force;
-        }
-    }
+    return steps;
+}
 
-    modelCalcBounds (model);
+static int modelWobblyFlags(float velocitySum, float forceSum)
+{
+    int wobbly = 0;
 
     if (velocitySum > 0.5f)
         wobbly |= WobblyVelocity;
@@ -370,38 +386,271 @@ static int modelStep(Model *model, float friction, float k, float time)
     return wobbly;
 }
 
-static void bezierPatchEvaluate (Model *model, float u, float v,
-        float *patchX, float *patchY)
+static int modelStep(Model *model, float friction, float k, int steps)
 {
-    float coeffsU[4], coeffsV[4];
-    float x, y;
-    int   i, j;
+    float velocitySum = 0.0f;
+    float forceSum = 0.0f;
+    int   j;
 
-    coeffsU[0] = (1 - u) * (1 - u) * (1 - u);
-    coeffsU[1] = 3 * u * (1 - u) * (1 - u);
-    coeffsU[2] = 3 * u * u * (1 - u);
-    coeffsU[3] = u * u * u;
+    for (j = 0; j < steps; j++)
+    {
+        modelExertSpringForces(model, k);
+        modelStepObjects(model, friction, &velocitySum, &forceSum);
+    }
 
-    coeffsV[0] = (1 - v) * (1 - v) * (1 - v);
-    coeffsV[1] = 3 * v * (1 - v) * (1 - v);
-    coeffsV[2] = 3 * v * v * (1 - v);
-    coeffsV[3] = v * v * v;
+    return modelWobblyFlags(velocitySum, forceSum);
+}
 
-    x = y = 0.0f;
+/*
+ * Stepping several models with the same grid size at once.
+ *
+ * The models are copied into interleaved arrays, in which the values of one
+ * object of all models are next to each other, WOBBLY_LANES models per
+ * vector. All inner loops thus run over the models instead of over the short
+ * grid rows, and are written with GCC vector types so that they are
+ * vectorized in any build. Lanes past the last model are zero and immobile.
+ * Models which need fewer steps than others in the group are masked out of
+ * the remaining steps.
+ */
+#define WOBBLY_LANES 4
 
-    for (i = 0; i < 4; i++)
+typedef float LaneVector __attribute__((vector_size(WOBBLY_LANES * sizeof(float))));
+typedef int   LaneBits __attribute__((vector_size(WOBBLY_LANES * sizeof(int))));
+
+typedef struct _PendingStep {
+    struct wobbly_surface *surface;
+    Model *model;
+    int   steps;
+    float velocitySum, forceSum;
+} PendingStep;
+
+/* Scratch space for modelStepGroup, grown as needed */
+static LaneVector *groupData;
+static size_t groupCapacity;
+
+static void groupRelease(void)
+{
+    free(groupData);
+    groupData = NULL;
+    groupCapacity = 0;
+}
+
+static LaneVector laneAbs(LaneVector v)
+{
+    return (LaneVector)((LaneBits)v & 0x7fffffff);
+}
+
+/* Flush velocities which are far too small to be visible to zero. Velocities
+ * decay exponentially once a model settles, and would otherwise end up as
+ * denormals, which are very slow to compute with. */
+static LaneVector laneFlushTiny(LaneVector v)
+{
+    return (LaneVector)((LaneBits)v & (laneAbs(v) > 1e-20f));
+}
+
+static int groupReserve(size_t vectors)
+{
+    if (vectors <= groupCapacity)
+        return 1;
+
+    free(groupData);
+    groupData = aligned_alloc(sizeof(LaneVector), vectors * sizeof(LaneVector));
+    groupCapacity = groupData ? vectors : 0;
+
+    return groupData != NULL;
+}
+
+/* Step the models of the given surfaces, which must all have the same grid
+ * size. Returns 0 if the scratch space could not be allocated. */
+static int modelStepGroup(PendingStep *group, int count,
+        float friction, float k)
+{
+    Model *first = group[0].model;
+    int gridWidth = first->gridWidth;
+    int n = first->numObjects;
+    int blocks = (count + WOBBLY_LANES - 1) / WOBBLY_LANES;
+    LaneVector *px, *py, *vx, *vy, *fx, *fy, *mobile;
+    LaneVector *hpad, *vpad, *active, *velocity, *force;
+    float hk = 0.5f * k;
+    int maxSteps = 0;
+    int b, i, j, m, x, y, row, stride;
+
+    if (!groupReserve((size_t)blocks * (7 * n + 5)))
+        return 0;
+
+    px       = groupData;
+    py       = px + blocks * n;
+    vx       = py + blocks * n;
+    vy       = vx + blocks * n;
+    fx       = vy + blocks * n;
+    fy       = fx + blocks * n;
+    mobile   = fy + blocks * n;
+    hpad     = mobile + blocks * n;
+    vpad     = hpad + blocks;
+    active   = vpad + blocks;
+    velocity = active + blocks;
+    force    = velocity + blocks;
+
+    memset(fx, 0, 2 * blocks * n * sizeof(LaneVector));
+    memset(active, 0, 3 * blocks * sizeof(LaneVector));
+
+    /* Object i of model m is at lane m of vector i * blocks */
+    stride = blocks * WOBBLY_LANES;
+    for (m = 0; m < count; m++)
+    {
+        const Model *model = group[m].model;
+        float *restrict pxm = (float*)px + m;
+        float *restrict pym = (float*)py + m;
+        float *restrict vxm = (float*)vx + m;
+        float *restrict vym = (float*)vy + m;
+        float *restrict mobilem = (float*)mobile + m;
+
+        for (i = 0; i < n; i++)
+        {
+            pxm[i * stride]     = model->positionX[i];
+            pym[i * stride]     = model->positionY[i];
+            vxm[i * stride]     = model->velocityX[i];
+            vym[i * stride]     = model->velocityY[i];
+            mobilem[i * stride] = model->mobile[i];
+        }
+
+        ((float*)hpad)[m] = model->hpad;
+        ((float*)vpad)[m] = model->vpad;
+        if (group[m].steps > maxSteps)
+            maxSteps = group[m].steps;
+    }
+
+    /* Lanes past the last model stay at rest */
+    for (m = count; m < stride; m++)
     {
-        for (j = 0; j < 4; j++)
+        for (i = 0; i < n; i++)
         {
-            x += coeffsU[i] * coeffsV[j] *
-                model->objects[j * GRID_WIDTH + i].position.x;
-            y += coeffsU[i] * coeffsV[j] *
-                model->objects[j * GRID_HEIGHT + i].position.y;
+            ((float*)px)[i * stride + m] = ((float*)py)[i * stride + m] = 0;
+            ((float*)vx)[i * stride + m] = ((float*)vy)[i * stride + m] = 0;
+            ((float*)mobile)[i * stride + m] = 0;
         }
+
+        ((float*)hpad)[m] = ((float*)vpad)[m] = 0;
     }
 
-    *patchX = x;
-    *patchY = y;
+    for (j = 0; j < maxSteps; j++)
+    {
+        for (m = 0; m < count; m++)
+            ((float*)active)[m] = j < group[m].steps ? 1.0f : 0.0f;
+
+        /* Horizontal springs, between objects row + x and row + x + 1 */
+        for (y = 0; y < first->gridHeight; y++)
+        {
+            row = y * gridWidth;
+            for (x = 0; x < gridWidth - 1; x++)
+            {
+                LaneVector *restrict pxa = px + (row + x) * blocks;
+                LaneVector *restrict pya = py + (row + x) * blocks;
+                LaneVector *restrict fxa = fx + (row + x) * blocks;
+                LaneVector *restrict fya = fy + (row + x) * blocks;
+
+                for (b = 0; b < blocks; b++)
+                {
+                    LaneVector sx = hk * (pxa[b + blocks] - pxa[b] - hpad[b]);
+                    LaneVector sy = hk * (pya[b + blocks] - pya[b]);
+
+                    fxa[b] += sx;
+                    fya[b] += sy;
+                    fxa[b + blocks] -= sx;
+                    fya[b + blocks] -= sy;
+                }
+            }
+        }
+
+        /* Vertical springs, between objects row - gridWidth + x and row + x */
+        for (i = gridWidth; i < n; i++)
+        {
+            LaneVector *restrict pxa = px + (i - gridWidth) * blocks;
+            LaneVector *restrict pya = py + (i - gridWidth) * blocks;
+            LaneVector *restrict fxa = fx + (i - gridWidth) * blocks;
+            LaneVector *restrict fya = fy + (i - gridWidth) * blocks;
+            int below = gridWidth * blocks;
+
+            for (b = 0; b < blocks; b++)
+            {
+                LaneVector dx = hk * (pxa[b + below] - pxa[b]);
+                LaneVector dy = hk * (pya[b + below] - pya[b] - vpad[b]);
+
+                fxa[b] += dx;
+                fya[b] += dy;
+                fxa[b + below] -= dx;
+                fya[b + below] -= dy;
+            }
+        }
+
+        /* Move the objects, keeping models which are done in place */
+        for (i = 0; i < n * blocks; i += blocks)
+        {
+            for (b = 0; b < blocks; b++)
+            {
+                LaneVector act = active[b];
+                LaneVector forceX = fx[i + b] - friction * vx[i + b];
+                LaneVector forceY = fy[i + b] - friction * vy[i + b];
+                LaneVector newX = mobile[i + b] *
+                    (vx[i + b] + forceX / (float)WOBBLY_MASS);
+                LaneVector newY = mobile[i + b] *
+                    (vy[i + b] + forceY / (float)WOBBLY_MASS);
+
+                vx[i + b] = act * laneFlushTiny(newX) + (1.0f - act) * vx[i + b];
+                vy[i + b] = act * laneFlushTiny(newY) + (1.0f - act) * vy[i + b];
+                px[i + b] += act * vx[i + b];
+                py[i + b] += act * vy[i + b];
+
+                force[b] += act * mobile[i + b] *
+                    (laneAbs(forceX) + laneAbs(forceY));
+                velocity[b] += act * (laneAbs(vx[i + b]) + laneAbs(vy[i + b]));
+
+                fx[i + b] = fy[i + b] = (LaneVector){0};
+            }
+        }
+    }
+
+    for (m = 0; m < count; m++)
+    {
+        Model *model = group[m].model;
+        const float *restrict pxm = (const float*)px + m;
+        const float *restrict pym = (const float*)py + m;
+        const float *restrict vxm = (const float*)vx + m;
+        const float *restrict vym = (const float*)vy + m;
+
+        for (i = 0; i < n; i++)
+        {
+            model->positionX[i] = pxm[i * stride];
+            model->positionY[i] = pym[i * stride];
+            model->velocityX[i] = vxm[i * stride];
+            model->velocityY[i] = vym[i * stride];
+        }
+
+        group[m].velocitySum = ((float*)velocity)[m];
+        group[m].forceSum    = ((float*)force)[m];
+    }
+
+    return 1;
+}
+
+/* Bernstein polynomials of the given degree at t, stored in coeffs */
+static void bernsteinCoefficients(int degree, float t, float *coeffs)
+{
+    int n, i;
+
+    coeffs[0] = 1.0f;
+    for (n = 1; n <= degree; n++)
+    {
+        float carry = 0.0f;
+        for (i = 0; i < n; i++)
+        {
+            float c = coeffs[i];
+            coeffs[i] = carry + (1 - t) * c;
+            carry = t * c;
+        }
+
+        coeffs[n] = carry;
+    }
 }
 
 static int wobblyEnsureModel(struct wobbly_surface *surface)
@@ -419,123 +668,220 @@ static int wobblyEnsureModel(struct wobbly_surface *surface)
     return 1;
 }
 
-static float objectDistance(Object *object, float x, float y)
+static int modelFindNearestObject(Model *model, float x, float y)
 {
-    float dx, dy;
-    dx = object->position.x - x;
-    dy = object->position.y - y;
-
-    return sqrt(dx * dx + dy * dy);
-}
-
-static Object *modelFindNearestObject(Model *model, float x, float y)
-{
-    Object *object = &model->objects[0];
-    float  distance, minDistance = 0.0;
-    int    i;
+    int   object = 0;
+    float dx, dy, distance, minDistance = 0.0;
+    int   i;
 
     for (i = 0; i < model->numObjects; i++)
     {
-        distance = objectDistance(&model->objects[i], x, y);
+        dx = model->positionX[i] - x;
+        dy = model->positionY[i] - y;
+        distance = dx * dx + dy * dy;
         if (i == 0 || distance < minDistance)
         {
             minDistance = distance;
-            object = &model->objects[i];
+            object = i;
         }
     }
 
     return object;
 }
 
-static void modelAdjustCorners(Model *model, int x, int y,
-        int width, int height, int make_immobile)
+/* Push the neighbours of the given object away through their springs */
+static void modelPushNeighbours(Model *model, int object)
 {
-    Object *o;
-    o = &model->objects[0];
-    o->position.x = x;
-    o->position.y = y;
-    o->immobile = make_immobile;
+    int gridWidth = model->gridWidth;
+    int x = object % gridWidth;
+    int y = object / gridWidth;
+
+    if (x + 1 < gridWidth)
+        model->velocityX[object + 1] -= model->hpad * 0.05f;
+    if (x > 0)
+        model->velocityX[object - 1] += model->hpad * 0.05f;
+    if (y + 1 < model->gridHeight)
+        model->velocityY[object + gridWidth] -= model->vpad * 0.05f;
+    if (y > 0)
+        model->velocityY[object - gridWidth] += model->vpad * 0.05f;
+}
 
-    o = &model->objects[GRID_WIDTH - 1];
-    o->position.x = x + width;
-    o->position.y = y;
-    o->immobile = make_immobile;
+static void modelSetObject(Model *model, int object, float x, float y,
+        int immobile)
+{
+    model->positionX[object] = x;
+    model->positionY[object] = y;
+    objectSetImmobile(model, object, immobile);
+}
 
-    o = &model->objects[GRID_WIDTH * (GRID_HEIGHT - 1)];
-    o->position.x = x;
-    o->position.y = y + height;
-    o->immobile = make_immobile;
+static void modelAdjustCorners(Model *model, int x, int y,
+        int width, int height, int make_immobile)
+{
+    int gridWidth = model->gridWidth;
 
-    o = &model->objects[model->numObjects - 1];
-    o->position.x = x + width;
-    o->position.y = y + height;
-    o->immobile = make_immobile;
+    modelSetObject(model, 0, x, y, make_immobile);
+    modelSetObject(model, gridWidth - 1, x + width, y, make_immobile);
+    modelSetObject(model, model->numObjects - gridWidth,
+        x, y + height, make_immobile);
+    modelSetObject(model, model->numObjects - 1,
+        x + width, y + height, make_immobile);
 
-    if (!model->anchorObject)
-        model->anchorObject = &model->objects[0];
+    if (model->anchorObject < 0)
+        model->anchorObject = 0;
 }
 
 static int modelRemoveEdgeAnchors(Model *model)
 {
+    int corners[4] = {
+        0, model->gridWidth - 1,
+        model->numObjects - model->gridWidth, model->numObjects - 1,
+    };
     int result = 0;
-    Object *o;
+    int i;
 
-    o = &model->objects[0];
-    if (o != model->anchorObject)
+    for (i = 0; i < 4; i++)
     {
-        result |= o->immobile;
-        o->immobile = 0;
+        if (corners[i] != model->anchorObject)
+        {
+            result |= objectIsImmobile(model, corners[i]);
+            objectSetImmobile(model, corners[i], 0);
+        }
     }
 
-    o = &model->objects[GRID_WIDTH - 1];
-    if (o != model->anchorObject)
+    return result;
+}
+
+static int wobblyNeedsStep(struct wobbly_surface *surface)
+{
+    WobblyWindow *ww = surface->ww;
+
+    return ww->wobbly & (WobblyInitial | WobblyVelocity | WobblyForce);
+}
+
+/* Update the surface after its model has been stepped */
+static void wobblyFinishStep(struct wobbly_surface *surface, int wobbly)
+{
+    WobblyWindow *ww = surface->ww;
+
+    ww->wobbly = wobbly;
+    modelCalcBounds(ww->model);
+    if (!ww->wobbly)
     {
-        result |= o->immobile;
-        o->immobile = 0;
+        surface->x = ww->model->topLeft.x;
+        surface->y = ww->model->topLeft.y;
+        surface->synced = 1;
     }
+}
+
+static int compareGridSize(const void *a, const void *b)
+{
+    const Model *ma = ((const PendingStep*)a)->model;
+    const Model *mb = ((const PendingStep*)b)->model;
+
+    if (ma->gridWidth != mb->gridWidth)
+        return ma->gridWidth - mb->gridWidth;
 
-    o = &model->objects[GRID_WIDTH * (GRID_HEIGHT - 1)];
-    if (o != model->anchorObject)
+    return ma->gridHeight - mb->gridHeight;
+}
+
+static int sameGridSize(const PendingStep *a, const PendingStep *b)
+{
+    return compareGridSize(a, b) == 0;
+}
+
+/* Step the models of the group one by one */
+static void wobblyStepEach(PendingStep *group, int count,
+        float friction, float springK)
+{
+    int i;
+
+    for (i = 0; i < count; i++)
     {
-        result |= o->immobile;
-        o->immobile = 0;
+        wobblyFinishStep(group[i].surface,
+            modelStep(group[i].model, friction, springK, group[i].steps));
     }
+}
 
-    o = &model->objects[model->numObjects - 1];
-    if (o != model->anchorObject)
+static void wobblyStepGroup(PendingStep *group, int count,
+        float friction, float springK)
+{
+    int i;
+
+    /* A single model is faster without copying it around */
+    if ((count < 2) || !modelStepGroup(group, count, friction, springK))
     {
-        result |= o->immobile;
-        o->immobile = 0;
+        wobblyStepEach(group, count, friction, springK);
+        return;
     }
 
-    return result;
+    for (i = 0; i < count; i++)
+    {
+        wobblyFinishStep(group[i].surface,
+            modelWobblyFlags(group[i].velocitySum, group[i].forceSum));
+    }
 }
 
 void wobbly_prepare_paint(struct wobbly_surface *surface, int msSinceLastPaint)
 {
-    WobblyWindow *ww = surface->ww;
-    float  friction, springK;
+    wobbly_prepare_paint_batch(&surface, &msSinceLastPaint, 1);
+}
+
+void wobbly_prepare_paint_batch(struct wobbly_surface **surfaces,
+    const int *msSinceLastPaint, int count)
+{
+    PendingStep single, *pending;
+    float friction, springK;
+    int i, start, end, numPending = 0;
 
     friction = wobbly_settings_get_friction();
     springK  = wobbly_settings_get_spring_k();
 
-    if (ww->wobbly)
+    pending = count > 1 ? malloc(count * sizeof(PendingStep)) : &single;
+    for (i = 0; i < count; i++)
     {
-        if (ww->wobbly & (WobblyInitial | WobblyVelocity | WobblyForce))
+        WobblyWindow *ww = surfaces[i]->ww;
+        int steps;
+
+        if (!ww->wobbly || !wobblyNeedsStep(surfaces[i]))
+            continue;
+
+        steps = modelTakeSteps(ww->model, (ww->wobbly & WobblyVelocity) ?
+            msSinceLastPaint[i] : 16);
+        if (!steps)
         {
-            ww->wobbly = modelStep(ww->model, friction, springK,
-                    (ww->wobbly & WobblyVelocity) ?
-                    msSinceLastPaint : 16);
-
-            if (ww->wobbly) {
-                modelCalcBounds(ww->model);
-            } else {
-                surface->x = ww->model->topLeft.x;
-                surface->y = ww->model->topLeft.y;
-                surface->synced = 1;
-            }
+            wobblyFinishStep(surfaces[i], WobblyInitial);
+            continue;
         }
+
+        if (!pending)
+        {
+            wobblyFinishStep(surfaces[i],
+                modelStep(ww->model, friction, springK, steps));
+            continue;
+        }
+
+        pending[numPending].surface = surfaces[i];
+        pending[numPending].model   = ww->model;
+        pending[numPending].steps   = steps;
+        numPending++;
+    }
+
+    if (!pending)
+        return;
+
+    /* Models with the same grid size are stepped together */
+    qsort(pending, numPending, sizeof(PendingStep), compareGridSize);
+    for (start = 0; start < numPending; start = end)
+    {
+        end = start + 1;
+        while (end < numPending && sameGridSize(&pending[start], &pending[end]))
+            end++;
+
+        wobblyStepGroup(pending + start, end - start, friction, springK);
     }
+
+    if (pending != &single)
+        free(pending);
 }
 
 void wobbly_done_paint(struct wobbly_surface *surface)
@@ -551,10 +897,13 @@ void wobbly_done_paint(struct wobbly_surface *surface)
 void wobbly_add_geometry(struct wobbly_surface *surface)
 {
     WobblyWindow *ww = surface->ww;
+    Model        *model = ww->model;
 
     float    width, height;
     float    deformedX, deformedY;
-    int      x, y, iw, ih;
+    float    coeffsU[WOBBLY_MAX_GRID], coeffsV[WOBBLY_MAX_GRID];
+    float    rowX[WOBBLY_MAX_GRID], rowY[WOBBLY_MAX_GRID];
+    int      x, y, i, j, iw, ih;
     float    cell_w, cell_h;
     GLfloat  *v, *uv;
 
@@ -575,13 +924,36 @@ void wobbly_add_geometry(struct wobbly_surface *surface)
         surface->v = v;
         surface->uv = uv;
 
+        /* Evaluate the bezier patch spanned by the objects, first collapsing
+         * the grid rows for the current v, then evaluating along u */
         for (y = 0; y < ih; y++)
         {
+            bernsteinCoefficients(model->gridHeight - 1,
+                (y * cell_h) / height, coeffsV);
+
+            for (i = 0; i < model->gridWidth; i++)
+            {
+                rowX[i] = rowY[i] = 0.0f;
+                for (j = 0; j < model->gridHeight; j++)
+                {
+                    rowX[i] += coeffsV[j] *
+                        model->positionX[j * model->gridWidth + i];
+                    rowY[i] += coeffsV[j] *
+                        model->positionY[j * model->gridWidth + i];
+                }
+            }
+
             for (x = 0; x < iw; x++)
             {
-                bezierPatchEvaluate(ww->model,
-                        (x * cell_w) / width, (y * cell_h) / height,
-                        &deformedX, &deformedY);
+                bernsteinCoefficients(model->gridWidth - 1,
+                    (x * cell_w) / width, coeffsU);
+
+                deformedX = deformedY = 0.0f;
+                for (i = 0; i < model->gridWidth; i++)
+                {
+                    deformedX += coeffsU[i] * rowX[i];
+                    deformedY += coeffsU[i] * rowY[i];
+                }
 
                 *v++ = deformedX;
                 *v++ = deformedY;
@@ -615,8 +987,8 @@ void wobbly_move_notify(struct wobbly_surface *surface, int x, int y)
     WobblyWindow *ww = surface->ww;
     if (ww->grabbed)
     {
-        ww->model->anchorObject->position.x = x + ww->grab_dx;
-        ww->model->anchorObject->position.y = y + ww->grab_dy;
+        ww->model->positionX[ww->model->anchorObject] = x + ww->grab_dx;
+        ww->model->positionY[ww->model->anchorObject] = y + ww->grab_dy;
 
         ww->wobbly |= WobblyInitial;
         surface->synced = 0;
@@ -628,28 +1000,11 @@ void wobbly_slight_wobble(struct wobbly_surface *surface)
     WobblyWindow *ww = surface->ww;
     if (wobblyEnsureModel(surface))
     {
-        Object *centerObj;
-        Spring *s;
-        int	   i;
+        int centerObj;
 
         centerObj = modelFindNearestObject(ww->model,
             surface->x + surface->width / 2, surface->y + surface->height / 2);
-
-        for (i = 0; i < ww->model->numSprings; i++)
-        {
-            s = &ww->model->springs[i];
-
-            if (s->a == centerObj)
-            {
-                s->b->velocity.x -= s->offset.x * 0.05f;
-                s->b->velocity.y -= s->offset.y * 0.05f;
-            }
-            else if (s->b == centerObj)
-            {
-                s->a->velocity.x += s->offset.x * 0.05f;
-                s->a->velocity.y += s->offset.y * 0.05f;
-            }
-        }
+        modelPushNeighbours(ww->model, centerObj);
 
         ww->wobbly |= WobblyInitial;
     }
@@ -671,33 +1026,18 @@ void wobbly_grab_notify(struct wobbly_surface *surface, int x, int y)
 
     if (wobblyEnsureModel(surface))
     {
-        Spring *s;
-        int	   i;
+        Model *model = ww->model;
 
-        if (ww->model->anchorObject)
-            ww->model->anchorObject->immobile = 0;
+        if (model->anchorObject >= 0)
+            objectSetImmobile(model, model->anchorObject, 0);
 
-        ww->model->anchorObject = modelFindNearestObject(ww->model, x, y);
-        ww->model->anchorObject->immobile = 1;
-        ww->grab_dx = ww->model->anchorObject->position.x - x;
-        ww->grab_dy = ww->model->anchorObject->position.y - y;
+        model->anchorObject = modelFindNearestObject(model, x, y);
+        objectSetImmobile(model, model->anchorObject, 1);
+        ww->grab_dx = model->positionX[model->anchorObject] - x;
+        ww->grab_dy = model->positionY[model->anchorObject] - y;
 
         ww->grabbed = 1;
-        for (i = 0; i < ww->model->numSprings; i++)
-        {
-            s = &ww->model->springs[i];
-
-            if (s->a == ww->model->anchorObject)
-            {
-                s->b->velocity.x -= s->offset.x * 0.05f;
-                s->b->velocity.y -= s->offset.y * 0.05f;
-            }
-            else if (s->b == ww->model->anchorObject)
-            {
-                s->a->velocity.x += s->offset.x * 0.05f;
-                s->a->velocity.y += s->offset.y * 0.05f;
-            }
-        }
+        modelPushNeighbours(model, model->anchorObject);
 
         ww->wobbly |= WobblyInitial;
     }
@@ -710,10 +1050,10 @@ void wobbly_ungrab_notify(struct wobbly_surface *surface)
     {
         if (ww->model)
         {
-            if (ww->model->anchorObject)
-                ww->model->anchorObject->immobile = 0;
+            if (ww->model->anchorObject >= 0)
+                objectSetImmobile(ww->model, ww->model->anchorObject, 0);
 
-            ww->model->anchorObject = NULL;
+            ww->model->anchorObject = -1;
 
             ww->wobbly |= WobblyInitial;
         }
@@ -751,9 +1091,9 @@ void wobbly_fini(struct wobbly_surface *surface)
 
     if (ww->model)
     {
-        free(ww->model->objects);
-        free(ww->model);
+        destroyModel(ww->model);
         free(surface->v);
+        free(surface->uv);
     }
 
     free (ww);
@@ -766,10 +1106,10 @@ void wobbly_force_geometry(struct wobbly_surface *surface,
 
     if (wobblyEnsureModel(surface))
     {
-		if (!ww->grabbed && ww->model->anchorObject)
+		if (!ww->grabbed && ww->model->anchorObject >= 0)
 		{
-		    ww->model->anchorObject->immobile = 0;
-		    ww->model->anchorObject = NULL;
+		    objectSetImmobile(ww->model, ww->model->anchorObject, 0);
+		    ww->model->anchorObject = -1;
 		}
 
         surface->x = x;
@@ -793,7 +1133,8 @@ void wobbly_unenforce_geometry(struct wobbly_surface *surface)
     {
         if (modelRemoveEdgeAnchors(ww->model))
         {
-            if (!ww->model->anchorObject || !ww->model->anchorObject->immobile)
+            if (ww->model->anchorObject < 0 ||
+                !objectIsImmobile(ww->model, ww->model->anchorObject))
             {
                 modelSetMiddleAnchor(ww->model, surface->x, surface->y,
                     surface->width, surface->height);
@@ -812,8 +1153,8 @@ void wobbly_translate(struct wobbly_surface *surface, int dx, int dy)
     {
         for (int i = 0; i < ww->model->numObjects; i++)
         {
-            ww->model->objects[i].position.x += dx;
-            ww->model->objects[i].position.y += dy;
+            ww->model->positionX[i] += dx;
+            ww->model->positionY[i] += dy;
         }
 
         ww->model->topLeft.x += dx;
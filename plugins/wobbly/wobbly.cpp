@@ -4,6 +4,7 @@
 #include <wayfire/view-transform.hpp>
 #include <wayfire/workspace-manager.hpp>
 #include <wayfire/render-manager.hpp>
+#include <algorithm>
 
 extern "C"
 {
@@ -150,6 +151,7 @@ namespace wobbly_settings
 wf::option_wrapper_t<double> friction{"wobbly/friction"};
 wf::option_wrapper_t<double> spring_k{"wobbly/spring_k"};
 wf::option_wrapper_t<int> resolution{"wobbly/grid_resolution"};
+wf::option_wrapper_t<int> max_physics_grid{"wobbly/max_physics_grid"};
 }
 
 extern "C"
@@ -165,6 +167,12 @@ extern "C"
         return wf::clamp((double)wobbly_settings::spring_k,
             MINIMAL_SPRING_K, MAXIMAL_SPRING_K);
     }
+
+    int wobbly_settings_get_max_grid()
+    {
+        return wf::clamp((int)wobbly_settings::max_physics_grid,
+            WOBBLY_MIN_GRID, WOBBLY_MAX_GRID);
+    }
 }
 
 namespace wf
@@ -483,10 +491,17 @@ class wobbly_state_free_t : public iwobbly_state_t
 };
 }
 
+class wf_wobbly;
+
+/**
+ * All existing wobbly transformers. The models of the transformers on an
+ * output are stepped together, see wayfire_wobbly::update_wobblies().
+ */
+static std::vector<wf_wobbly*> all_wobblies;
+
 class wf_wobbly : public wf::view_transformer_t
 {
     wayfire_view view;
-    wf::effect_hook_t pre_hook;
 
     wf::signal_callback_t view_removed = [=] (wf::signal_data_t*)
     {
@@ -510,9 +525,6 @@ class wf_wobbly : public wf::view_transformer_t
 
         if (!view->get_output())
         {
-            // Destructor won't be able to disconnect bc view output is invalid
-            sig->output->render->rem_effect(&pre_hook);
-
             return destroy_self();
         }
 
@@ -524,10 +536,6 @@ class wf_wobbly : public wf::view_transformer_t
         auto new_geometry = view->get_output()->get_layout_geometry();
         state->translate_model(old_geometry.x - new_geometry.x,
             old_geometry.y - new_geometry.y);
-
-        sig->output->render->rem_effect(&pre_hook);
-        view->get_output()->render->add_effect(&pre_hook,
-            wf::OUTPUT_EFFECT_PRE);
     };
 
     std::unique_ptr<wobbly_surface> model;
@@ -561,9 +569,7 @@ class wf_wobbly : public wf::view_transformer_t
         this->view = view;
         init_model();
         last_frame = wf::get_current_time();
-
-        pre_hook = [=] () { update_model(); };
-        view->get_output()->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE);
+        all_wobblies.push_back(this);
 
         view->connect_signal("unmapped", &view_removed);
         view->connect_signal("tiled", &view_state_changed);
@@ -606,7 +612,22 @@ class wf_wobbly : public wf::view_transformer_t
         return point;
     }
 
-    void update_model()
+    wf::output_t *get_output()
+    {
+        return view->get_output();
+    }
+
+    wobbly_surface *get_model()
+    {
+        return model.get();
+    }
+
+    /**
+     * Update the wobbly state before the model is stepped.
+     *
+     * @return The time in milliseconds since the last frame.
+     */
+    int prepare_frame()
     {
         view->damage();
 
@@ -617,20 +638,25 @@ class wf_wobbly : public wf::view_transformer_t
         state->handle_frame();
         view->connect_signal("geometry-changed", &this->view_geometry_changed);
 
-        /* Update all the wobbly model */
         auto now = wf::get_current_time();
-        wobbly_prepare_paint(model.get(), now - last_frame);
-
-        /* Update wobbly geometry */
+        int elapsed = now - last_frame;
         last_frame = now;
+
+        return elapsed;
+    }
+
+    /**
+     * Update the wobbly geometry after the model has been stepped.
+     *
+     * @return Whether the wobbly effect is done.
+     */
+    bool finish_frame()
+    {
         wobbly_add_geometry(model.get());
         wobbly_done_paint(model.get());
         view->damage();
 
-        if (state->is_wobbly_done())
-        {
-            destroy_self();
-        }
+        return state->is_wobbly_done();
     }
 
     void render_box(wf::texture_t src_tex, wlr_box src_box,
@@ -780,11 +806,8 @@ class wf_wobbly : public wf::view_transformer_t
     {
         state = nullptr;
         wobbly_fini(model.get());
-
-        if (view->get_output())
-        {
-            view->get_output()->render->rem_effect(&pre_hook);
-        }
+        all_wobblies.erase(
+            std::find(all_wobblies.begin(), all_wobblies.end(), this));
 
         view->disconnect_signal("unmapped", &view_removed);
         view->disconnect_signal("tiled", &view_state_changed);
@@ -797,6 +820,49 @@ class wf_wobbly : public wf::view_transformer_t
 class wayfire_wobbly : public wf::plugin_interface_t
 {
     wf::signal_callback_t wobbly_changed;
+    wf::effect_hook_t pre_hook = [=] () { update_wobblies(); };
+
+    /* Reused between frames to avoid allocations */
+    std::vector<wf_wobbly*> batch;
+    std::vector<wobbly_surface*> batch_models;
+    std::vector<int> batch_times;
+
+    /** Step the models of all wobbly views on the output in one batch. */
+    void update_wobblies()
+    {
+        batch.clear();
+        for (auto wobbly : all_wobblies)
+        {
+            if (wobbly->get_output() == output)
+            {
+                batch.push_back(wobbly);
+            }
+        }
+
+        if (batch.empty())
+        {
+            return;
+        }
+
+        batch_models.clear();
+        batch_times.clear();
+        for (auto wobbly : batch)
+        {
+            batch_times.push_back(wobbly->prepare_frame());
+            batch_models.push_back(wobbly->get_model());
+        }
+
+        wobbly_prepare_paint_batch(batch_models.data(), batch_times.data(),
+            batch_models.size());
+
+        for (auto wobbly : batch)
+        {
+            if (wobbly->finish_frame())
+            {
+                wobbly->destroy_self();
+            }
+        }
+    }
 
   public:
     void init() override
@@ -810,6 +876,7 @@ class wayfire_wobbly : public wf::plugin_interface_t
         };
 
         output->connect_signal("wobbly-event", &wobbly_changed);
+        output->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE);
 
         wobbly_graphics::load_program();
     }
@@ -875,6 +942,7 @@ class wayfire_wobbly : public wf::plugin_interface_t
         }
 
         wobbly_graphics::destroy_program();
+        output->render->rem_effect(&pre_hook);
         output->disconnect_signal("wobbly-event", &wobbly_changed);
     }
 };
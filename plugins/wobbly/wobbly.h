@@ -15,8 +15,13 @@
 #define MAXIMAL_SPRING_K 10.0
 #define WOBBLY_MASS 15.0
 
+/* Limits for the number of objects along each side of the spring model */
+#define WOBBLY_MIN_GRID 4
+#define WOBBLY_MAX_GRID 16
+
 double wobbly_settings_get_friction();
 double wobbly_settings_get_spring_k();
+int wobbly_settings_get_max_grid();
 
 struct wobbly_surface
 {
@@ -47,6 +52,10 @@ void wobbly_ungrab_notify(struct wobbly_surface *surface);
 void wobbly_resize(struct wobbly_surface *surface, int width, int height);
 void wobbly_move_notify(struct wobbly_surface *surface, int x, int y);
 void wobbly_prepare_paint(struct wobbly_surface *surface, int msSinceLastPaint);
+/* Step the models of several surfaces at once. msSinceLastPaint holds the
+ * time since the last paint of each surface. */
+void wobbly_prepare_paint_batch(struct wobbly_surface **surfaces,
+    const int *msSinceLastPaint, int count);
 void wobbly_done_paint(struct wobbly_surface *surface);
 void wobbly_add_geometry(struct wobbly_surface *surface);
 struct wobbly_rect wobbly_boundingbox(struct wobbly_surface *surface);
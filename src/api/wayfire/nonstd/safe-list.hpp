@@ -1,68 +1,121 @@
 #ifndef WF_SAFE_LIST_HPP
 #define WF_SAFE_LIST_HPP
 
-#include <list>
-#include <memory>
+#include <vector>
+#include <optional>
 #include <algorithm>
-#include <functional>
+#include <stdexcept>
+#include <utility>
 
-#include <wayland-server.h>
-
-#include "reverse.hpp"
-
-/* This is a trimmed-down wrapper of std::list<T>.
+/* This is a trimmed-down list container backed by a contiguous array.
  *
  * It supports safe iteration over all elements in the collection, where any
- * element can be deleted from the list at any given time (i.e even in a
- * for-each-like loop) */
+ * element can be deleted from or added to the list at any given time (i.e even
+ * in a for-each-like loop).
+ *
+ * Erased elements are left as empty slots (tombstones), and elements added
+ * while the list is being iterated are kept aside, so that the array is never
+ * resized during an iteration. Both are folded back into the array when the
+ * outermost iteration ends, or immediately if nothing iterates the list. */
 namespace wf
 {
-/* The object type depends on the safe list type, and the safe list type
- * needs access to the event loop. However, the event loop is typically
- * available from core.hpp. Because we can't resolve this circular dependency,
- * we provide a link to the event loop specially for the safe list */
-namespace _safe_list_detail
-{
-/* In main.cpp, and initialized there */
-extern wl_event_loop *event_loop;
-void idle_cleanup_func(void *data);
-}
-
 template<class T>
 class safe_list_t
 {
-    std::list<std::unique_ptr<T>> list;
-    wl_event_source *idle_cleanup_source = NULL;
+    struct pending_t
+    {
+        /* Index in list before which the element is to be inserted */
+        size_t position;
+        std::optional<T> value;
+    };
+
+    /* The elements of the list, empty slots are erased elements */
+    mutable std::vector<std::optional<T>> list;
+    /* Elements added during an iteration, sorted by position */
+    mutable std::vector<pending_t> pending;
+    /* Buffer for compaction, kept around to reuse its memory */
+    mutable std::vector<std::optional<T>> scratch;
+    /* Number of empty slots in list */
+    mutable size_t removed = 0;
+    /* Nesting depth of the running iterations over the list */
+    mutable int iteration_depth = 0;
+
+    /* Marks the list as iterated for the lifetime of the guard */
+    struct iteration_guard_t
+    {
+        const safe_list_t *self;
+        iteration_guard_t(const safe_list_t *self) : self(self)
+        {
+            ++self->iteration_depth;
+        }
+
+        ~iteration_guard_t()
+        {
+            if ((--self->iteration_depth == 0) &&
+                (self->removed || !self->pending.empty()))
+            {
+                self->compact();
+            }
+        }
+    };
 
-    /* Remove all invalidated elements in the list */
-    std::function<void()> do_cleanup = [&] ()
+    /* Call func for each slot of the list and the pending elements, in the
+     * order the elements will have after compaction */
+    template<class Func>
+    void visit_slots(Func func) const
     {
-        auto it = list.begin();
-        while (it != list.end())
+        size_t next = 0;
+        for (size_t i = 0; i <= list.size(); i++)
         {
-            if (*it)
+            while (next < pending.size() && pending[next].position <= i)
             {
-                ++it;
-            } else
+                func(pending[next++].value);
+            }
+
+            if (i < list.size())
             {
-                it = list.erase(it);
+                func(list[i]);
             }
         }
+    }
 
-        idle_cleanup_source = NULL;
-    };
+    /* Drop the empty slots and merge the pending elements into the list */
+    void compact() const
+    {
+        scratch.clear();
+        visit_slots([&] (std::optional<T>& slot)
+        {
+            if (slot)
+            {
+                scratch.push_back(std::move(slot));
+            }
+        });
 
-    /* Return whether the list has invalidated elements */
-    bool is_dirty() const
+        list.swap(scratch);
+        scratch.clear();
+        pending.clear();
+        removed = 0;
+    }
+
+    void insert_slot(size_t position, T&& value)
     {
-        return idle_cleanup_source;
+        if (iteration_depth > 0)
+        {
+            /* Keep the order of insertion for elements at the same position */
+            auto it = std::upper_bound(pending.begin(), pending.end(), position,
+                [] (size_t pos, const pending_t& p) { return pos < p.position; });
+            pending.insert(it, pending_t{position, std::move(value)});
+        } else
+        {
+            list.emplace(list.begin() + position, std::move(value));
+        }
     }
 
   public:
     safe_list_t()
     {}
 
-    /* Copy the not-erased elements from other, but do not copy the idle source */
+    /* Copy the not-erased elements from other */
     safe_list_t(const safe_list_t& other)
     {
         *this = other;
@@ -70,58 +123,75 @@ class safe_list_t
 
     safe_list_t& operator =(const safe_list_t& other)
     {
-        this->idle_cleanup_source = NULL;
-        other.for_each([&] (auto& el)
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        clear();
+        other.visit_slots([&] (const std::optional<T>& slot)
         {
-            this->push_back(el);
+            if (slot)
+            {
+                insert_slot(list.size(), T(*slot));
+            }
         });
+
+        return *this;
     }
 
-    safe_list_t(safe_list_t&& other) = default;
-    safe_list_t& operator =(safe_list_t&& other) = default;
+    safe_list_t(safe_list_t&& other)
+    {
+        *this = std::move(other);
+    }
 
-    ~safe_list_t()
+    safe_list_t& operator =(safe_list_t&& other)
     {
-        if (idle_cleanup_source)
-        {
-            wl_event_source_remove(idle_cleanup_source);
-        }
+        list    = std::move(other.list);
+        pending = std::move(other.pending);
+        removed = std::exchange(other.removed, 0);
+        other.list.clear();
+        other.pending.clear();
+
+        return *this;
     }
 
     T& back()
     {
-        /* No invalidated elements */
-        if (!is_dirty())
+        /* No erased or pending elements */
+        if (!removed && pending.empty() && !list.empty())
         {
             return *list.back();
         }
 
-        auto it = list.rbegin();
-        while (it != list.rend() && (*it) == nullptr)
+        /* Walk the slots in reverse, pending elements come before the slot
+         * they are inserted at */
+        size_t next = pending.size();
+        for (size_t i = list.size() + 1; i-- > 0;)
         {
-            ++it;
-        }
+            while (next > 0 && pending[next - 1].position >= i)
+            {
+                if (pending[--next].value)
+                {
+                    return *pending[next].value;
+                }
+            }
 
-        if (it == list.rend())
-        {
-            throw std::out_of_range("back() called on an empty list!");
+            if ((i > 0) && list[i - 1])
+            {
+                return *list[i - 1];
+            }
         }
 
-        return **it;
+        throw std::out_of_range("back() called on an empty list!");
     }
 
     size_t size() const
     {
-        if (!is_dirty())
+        size_t sz = list.size() - removed;
+        for (auto& p : pending)
         {
-            return list.size();
-        }
-
-        /* Count non-null elements, because that's the real size */
-        size_t sz = 0;
-        for (auto& it : list)
-        {
-            sz += (it != nullptr);
+            sz += p.value.has_value();
         }
 
         return sz;
@@ -130,13 +200,13 @@ class safe_list_t
     /* Push back by copying */
     void push_back(T value)
     {
-        list.push_back(std::make_unique<T>(std::move(value)));
+        insert_slot(list.size(), std::move(value));
     }
 
     /* Push back by moving */
     void emplace_back(T&& value)
     {
-        list.push_back(std::make_unique<T>(value));
+        insert_slot(list.size(), std::move(value));
     }
 
     enum insert_place_t
@@ -148,72 +218,69 @@ class safe_list_t
 
     /* Insert the given value at a position in the list, determined by the
      * check function. The value is inserted at the first position that
-     * check indicates, or at the end of the list otherwise */
-    void emplace_at(T&& value, std::function<insert_place_t(T&)> check)
+     * check indicates, or at the end of the list otherwise.
+     *
+     * check is called with insert_place_t(T&) and must not modify the list.
+     * Elements which are added during an iteration are not passed to check
+     * until that iteration ends. */
+    template<class Check>
+    void emplace_at(T&& value, Check check)
     {
-        auto it = list.begin();
-        while (it != list.end())
+        size_t position = list.size();
+        for (size_t i = 0; i < list.size(); i++)
         {
             /* Skip empty elements */
-            if (*it == nullptr)
+            if (!list[i])
             {
-                ++it;
                 continue;
             }
 
-            auto place = check(**it);
-            switch (place)
+            auto place = check(*list[i]);
+            if (place == INSERT_BEFORE)
             {
-              case INSERT_AFTER:
-                /* We can safely increment it, because it points to an
-                 * element in the list */
-                ++it;
-
-              // fall through
-              case INSERT_BEFORE:
-                list.emplace(it, std::make_unique<T>(value));
-
-                return;
-
-              default:
+                position = i;
+                break;
+            } else if (place == INSERT_AFTER)
+            {
+                position = i + 1;
                 break;
             }
-
-            ++it;
         }
 
-        /* If no place found, insert at the end */
-        emplace_back(std::move(value));
+        insert_slot(position, std::move(value));
     }
 
-    void insert_at(T value, std::function<insert_place_t(T&)> check)
+    template<class Check>
+    void insert_at(T value, Check check)
     {
         emplace_at(std::move(value), check);
     }
 
-    /* Call func for each non-erased element of the list */
-    void for_each(std::function<void(T&)> func) const
+    /* Call func for each non-erased element of the list.
+     * Elements added while iterating are not visited. */
+    template<class Func>
+    void for_each(Func func) const
     {
-        /* Go through all elements currently in the list */
-        auto it = list.begin();
-        for (int size = list.size(); size > 0; size--, it++)
+        iteration_guard_t guard{this};
+        for (size_t i = 0; i < list.size(); i++)
         {
-            if (*it)
+            if (list[i])
             {
-                func(**it);
+                func(*list[i]);
             }
         }
     }
 
     /* Call func for each non-erased element of the list in reversed order */
-    void for_each_reverse(std::function<void(T&)> func) const
+    template<class Func>
+    void for_each_reverse(Func func) const
     {
-        auto it = list.rbegin();
-        for (int size = list.size(); size > 0; size--, it++)
+        iteration_guard_t guard{this};
+        for (size_t i = list.size(); i-- > 0;)
         {
-            if (*it)
+            if (list[i])
             {
-                func(**it);
+                func(*list[i]);
             }
         }
     }
@@ -227,32 +294,35 @@ class safe_list_t
     /* Remove all elements from the list */
     void clear()
     {
-        remove_if([] (const T& el) { return true; });
+        remove_if([] (const T&) { return true; });
     }
 
     /* Remove all elements satisfying a given condition.
-     * This function resets their pointers and scheduling a cleanup operation */
-    void remove_if(std::function<bool(const T&)> predicate)
+     * The removed slots are emptied, and the list is compacted once it is no
+     * longer iterated. */
+    template<class Predicate>
+    void remove_if(Predicate predicate)
     {
-        bool actually_removed = false;
-        for (auto& it : list)
+        /* Freeing an element may run arbitrary code which uses the list */
+        iteration_guard_t guard{this};
+        for (size_t i = 0; i < list.size(); i++)
         {
-            if (it && predicate(*it))
+            if (list[i] && predicate(*list[i]))
             {
-                actually_removed = true;
-                /* First reset the element in the list, and then free resources */
-                auto copy = std::move(it);
-                it = nullptr;
-                /* Now copy goes out of scope */
+                /* Empty the slot before the element is destroyed: the
+                 * temporary returned by exchange dies at the end of the
+                 * statement, when the slot is already empty */
+                ++removed;
+                std::exchange(list[i], std::nullopt);
             }
         }
 
-        /* Schedule a clean-up, but be careful to not schedule it twice */
-        if (!idle_cleanup_source && actually_removed)
+        for (size_t i = 0; i < pending.size(); i++)
         {
-            idle_cleanup_source = wl_event_loop_add_idle(
-                _safe_list_detail::event_loop,
-                _safe_list_detail::idle_cleanup_func, &do_cleanup);
+            if (pending[i].value && predicate(*pending[i].value))
+            {
+                std::exchange(pending[i].value, std::nullopt);
+            }
         }
     }
 };
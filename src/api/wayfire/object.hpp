@@ -22,6 +22,38 @@ struct signal_data_t
 using signal_callback_t = std::function<void (signal_data_t*)>;
 class signal_provider_t;
 
+/**
+ * An interned signal name.
+ *
+ * Signal names are mapped to small integers once, when the signal_id_t is
+ * created. Connecting to and emitting a signal through its ID does not need
+ * to hash the name, so IDs should be used for signals which are emitted
+ * often. A typical use is a static or member variable:
+ *
+ *   static const wf::signal_id_t region_damaged{"region-damaged"};
+ *   view->emit_signal(region_damaged, nullptr);
+ *
+ * Signals connected or emitted by name and by ID are the same signal.
+ */
+class signal_id_t
+{
+  public:
+    /** Intern the given signal name. */
+    explicit signal_id_t(const std::string& name);
+
+    /** @return The interned index of the signal. */
+    uint32_t get() const
+    {
+        return id;
+    }
+
+    /** @return The name of the signal. */
+    const std::string& get_name() const;
+
+  private:
+    uint32_t id;
+};
+
 /**
  * Provides an interface to connect to signal providers.
  *
@@ -68,6 +100,8 @@ class signal_provider_t
   public:
     /** Register a connection to be called when the given signal is emitted. */
     void connect_signal(std::string name, signal_connection_t *callback);
+    /** Register a connection to be called when the given signal is emitted. */
+    void connect_signal(const signal_id_t& id, signal_connection_t *callback);
     /** Unregister a connection. */
     void disconnect_signal(signal_connection_t *callback);
 
@@ -85,6 +119,12 @@ class signal_provider_t
     /** Emit the given signal. No type checking for data is required */
     void emit_signal(std::string name, signal_data_t *data);
 
+    /**
+     * Emit the given signal. Does not allocate or look up the name, and is
+     * almost free if there are no listeners.
+     */
+    void emit_signal(const signal_id_t& id, signal_data_t *data);
+
     virtual ~signal_provider_t();
 
   protected:
@@ -93,6 +133,8 @@ class signal_provider_t
   private:
     class sprovider_impl;
     std::unique_ptr<sprovider_impl> sprovider_priv;
+    /* Connections disconnect themselves directly from the providers */
+    friend class signal_connection_t;
 };
 
 /**
@@ -245,6 +245,38 @@ void render_texture(wf::texture_t texture,
     glm::vec4 color = glm::vec4(1.f),
     uint32_t bits   = 0);
 
+/**
+ * Render a textured quad on the given framebuffer, but only the parts of it
+ * which are inside the given region. All rectangles of the region are drawn
+ * with a single draw call, so this should be preferred over scissoring and
+ * calling render_texture() for each rectangle.
+ *
+ * Note that the scissor test is disabled after this call.
+ *
+ * @param texture   The texture to render.
+ * @param fb        The framebuffer to render onto.
+ *                  It should have been already bound.
+ * @param geometry  The geometry of the quad to render, in the same coordinate
+ *                    system as the framebuffer geometry.
+ * @param damage    The region to render, in the same coordinate system as the
+ *                    framebuffer geometry.
+ * @param color     A color multiplier for each channel of the texture.
+ * @param bits      A bitwise OR of texture_rendering_flags_t. In this variant,
+ *                    TEX_GEOMETRY flag is ignored.
+ */
+void render_texture(wf::texture_t texture,
+    const wf::framebuffer_t& framebuffer,
+    const wf::geometry_t& geometry,
+    const wf::region_t& damage,
+    glm::vec4 color = glm::vec4(1.f),
+    uint32_t bits   = 0);
+
+/**
+ * @return The number of draw calls issued by the OpenGL helper functions
+ * during the current frame.
+ */
+uint32_t get_draw_call_count();
+
 /* Compiles the given shader source */
 GLuint compile_shader(std::string source, GLuint type);
 
@@ -316,6 +348,32 @@ class program_t : public noncopyable_t
     /** @return The program ID for the given texture type, or 0 on failure */
     int get_program_id(wf::texture_type_t type);
 
+    /**
+     * A handle to a uniform of the program. Handles stay valid when the
+     * program is recompiled, and are cheap to use every frame, as opposed
+     * to looking up the location by name.
+     */
+    struct uniform_t
+    {
+        int index = -1;
+    };
+
+    /** A handle to a vertex attribute of the program, see uniform_t. */
+    struct attrib_t
+    {
+        int index = -1;
+    };
+
+    /**
+     * Get a handle to the uniform with the given name. The locations for all
+     * texture types are resolved once, so the handle should be stored and
+     * reused instead of passing the name each frame.
+     */
+    uniform_t get_uniform(const std::string& name);
+
+    /** Get a handle to the attribute with the given name, see get_uniform() */
+    attrib_t get_attrib(const std::string& name);
+
     /** Set the given uniform for the currently used program. */
     void uniform1i(const std::string& name, int value);
     /** Set the given uniform for the currently used program. */
@@ -345,6 +403,24 @@ class program_t : public noncopyable_t
      */
     void attrib_divisor(const std::string& attrib, int divisor);
 
+    /** Set the given uniform for the currently used program. */
+    void uniform1i(uniform_t uniform, int value);
+    /** Set the given uniform for the currently used program. */
+    void uniform1f(uniform_t uniform, float value);
+    /** Set the given uniform for the currently used program. */
+    void uniform2f(uniform_t uniform, float x, float y);
+    /** Set the given uniform for the currently used program. */
+    void uniform4f(uniform_t uniform, const glm::vec4& value);
+    /** Set the given uniform for the currently used program. */
+    void uniformMatrix4f(uniform_t uniform, const glm::mat4& value);
+
+    /** Same as attrib_pointer(), but with a cached attribute handle. */
+    void attrib_pointer(attrib_t attrib,
+        int size, int stride, const void *ptr, GLenum type = GL_FLOAT);
+
+    /** Same as attrib_divisor(), but with a cached attribute handle. */
+    void attrib_divisor(attrib_t attrib, int divisor);
+
     /**
      * Set the active texture, and modify the builtin Y-inversion uniforms.
      * Will not work with custom programs.
@@ -361,6 +437,23 @@ class program_t : public noncopyable_t
     class impl;
     std::unique_ptr<impl> priv;
 };
+
+/**
+ * Get a program compiled from the given sources with program_t::compile().
+ *
+ * Programs are shared by all plugins and outputs which use the same sources,
+ * so that each shader is compiled only once. The program is freed when the
+ * last reference to it is dropped. Users must not recompile or free it.
+ */
+std::shared_ptr<program_t> get_shared_program(
+    const std::string& vertex_source, const std::string& fragment_source);
+
+/**
+ * Same as get_shared_program(), but the program is created with
+ * program_t::set_simple() and supports only RGBA textures.
+ */
+std::shared_ptr<program_t> get_shared_simple_program(
+    const std::string& vertex_source, const std::string& fragment_source);
 }
 
 /* utils */
@@ -0,0 +1,58 @@
+#ifndef WF_PER_OUTPUT_PLUGIN_HPP
+#define WF_PER_OUTPUT_PLUGIN_HPP
+
+#include <map>
+#include <memory>
+#include <wayfire/plugin.hpp>
+
+namespace wf
+{
+/**
+ * A global plugin which keeps a separate state object for each output it is
+ * enabled on. Options, shaders and other resources which do not depend on the
+ * output can be kept in the plugin and are thus loaded only once.
+ *
+ * @param Instance The per-output state. It is constructed with the output when
+ *   the plugin is enabled on it, and its destructor should undo everything it
+ *   has set up on the output (bindings, signal connections, grabs, ...).
+ */
+template<class Instance>
+class per_output_plugin_t : public plugin_interface_t
+{
+  public:
+    bool is_global() final
+    {
+        return true;
+    }
+
+    void init() override
+    {}
+
+    void handle_output_added(wf::output_t *output) override
+    {
+        output_instance[output] = create_instance(output);
+    }
+
+    void handle_output_removed(wf::output_t *output) override
+    {
+        output_instance.erase(output);
+    }
+
+    void fini() override
+    {
+        output_instance.clear();
+    }
+
+  protected:
+    /** The per-output state, for each output the plugin is enabled on */
+    std::map<wf::output_t*, std::unique_ptr<Instance>> output_instance;
+
+    /** Create the state for a new output */
+    virtual std::unique_ptr<Instance> create_instance(wf::output_t *output)
+    {
+        return std::make_unique<Instance>(output);
+    }
+};
+}
+
+#endif /* end of include guard: WF_PER_OUTPUT_PLUGIN_HPP */
@@ -119,11 +119,14 @@ class plugin_interface_t
      * The output this plugin is running on. Initialized by core.
      * Each output has its own set of plugin instances. This way, a plugin
      * rarely if ever needs to care about multi-monitor setups.
+     *
+     * Global plugins (see is_global()) have no output.
      */
-    wf::output_t *output;
+    wf::output_t *output = nullptr;
 
     /**
      * The grab interface of the plugin, initialized by core.
+     * Global plugins have no grab interface.
      */
     std::unique_ptr<plugin_grab_interface_t> grab_interface;
 
@@ -153,6 +156,35 @@ class plugin_interface_t
         return true;
     }
 
+    /**
+     * A plugin can request to be global. Instead of one instance per output,
+     * a global plugin is instantiated and initialized once, when it is first
+     * enabled on an output. It is then notified with handle_output_added()
+     * and handle_output_removed() for each output it is enabled on, and it is
+     * finalized after it has been removed from the last output.
+     *
+     * This avoids loading options, compiling shaders, etc. once per output.
+     * The per-output state can be kept with wf::per_output_plugin_t.
+     */
+    virtual bool is_global()
+    {
+        return false;
+    }
+
+    /**
+     * Called for global plugins, after init(), when the plugin is enabled on
+     * an output.
+     */
+    virtual void handle_output_added(wf::output_t *output)
+    {}
+
+    /**
+     * Called for global plugins, before fini(), when the plugin is disabled
+     * on an output or the output is destroyed.
+     */
+    virtual void handle_output_removed(wf::output_t *output)
+    {}
+
     virtual ~plugin_interface_t();
 
     /** Handle to the plugin's .so file, used by the plugin loader */
@@ -170,7 +202,7 @@ class plugin_interface_t
 using wayfire_plugin_load_func = wf::plugin_interface_t * (*)();
 
 /** The version of Wayfire's API/ABI */
-constexpr uint32_t WAYFIRE_API_ABI_VERSION = 2020'09'28'1;
+constexpr uint32_t WAYFIRE_API_ABI_VERSION = 2020'09'28'2;
 
 /**
  * Each plugin must also provide a function which returns the Wayfire API/ABI
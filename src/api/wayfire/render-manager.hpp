@@ -21,6 +21,13 @@ using render_hook_t = std::function<void (const wf::framebuffer_t& fb)>;
  * at certain parts of the repaint cycle */
 using effect_hook_t = std::function<void ()>;
 
+/**
+ * Animation drivers let plugins request frames only while they animate
+ * something. A driver is called once per frame, before the pre effect hooks,
+ * and returns whether its animation still has pending progress.
+ */
+using animation_driver_t = std::function<bool ()>;
+
 enum output_effect_type_t
 {
     /* Pre hooks are called before starting to repaint the output */
@@ -83,11 +90,32 @@ class render_manager : public wf::signal_provider_t
      * auto_redraw() provides the plugins to temporarily request redrawing
      * of the output regardless of damage.
      *
+     * Prefer animation drivers (see add_animation_driver()), which request
+     * frames only while an animation actually progresses.
+     *
      * @param always - Whether to always redraw, regardless of damage. Call
      *        set_redraw_always(false) once for each set_redraw_always(true).
      */
     void set_redraw_always(bool always = true);
 
+    /**
+     * Add an animation driver, and schedule a frame for it.
+     *
+     * While a driver returns true, the output is repainted on each frame,
+     * regardless of damage, and one more time after it returns false, so that
+     * the final state of the animation is shown. Drivers returning false do
+     * not cause any frames. If the driver's animation is restarted later,
+     * call schedule_redraw() to wake it up.
+     *
+     * Note that a repaint without damage only runs the effect hooks, post
+     * hooks and custom renderers. Drivers of animations which change the
+     * scene need to damage the changed parts themselves.
+     */
+    void add_animation_driver(animation_driver_t *driver);
+
+    /** Remove an animation driver. No-op if the driver was not added. */
+    void rem_animation_driver(animation_driver_t *driver);
+
     /**
      * Schedule a frame for the output. Note that if there is no damage for
      * the next frame, nothing will be redrawn
@@ -194,9 +222,16 @@ class render_manager : public wf::signal_provider_t
      * This function should be called inside the rendering cycle, i.e in a
      * render or an overlay hook.
      *
+     * The stream can be rendered at a lower resolution than the output, if it
+     * is only displayed downscaled. The larger of the two scales is used for
+     * both axes, rounded up to a multiple of 1/8. Changing the scale causes a
+     * full repaint of the stream.
+     *
      * @param stream The workspace stream to update
-     * @param scale_x Unused for now
-     * @param scale_y Unused for now
+     * @param scale_x The horizontal scale at which the stream is displayed,
+     *   in (0, 1].
+     * @param scale_y The vertical scale at which the stream is displayed,
+     *   in (0, 1].
      */
     void workspace_stream_update(workspace_stream_t& stream,
         float scale_x = 1, float scale_y = 1);
@@ -483,8 +483,43 @@ struct view_geometry_changed_signal : public _view_signal
  * on: view
  * when: Whenever a region of the view becomes damaged, for ex. when the client
  *   updates its contents.
- * argument: Unused.
  */
+struct view_damaged_signal : public _view_signal
+{
+    /**
+     * The damaged part of the view, in the same coordinate system as
+     * get_untransformed_bounding_box(). It is the whole untransformed
+     * bounding box if the damage was not caused by the view's surfaces,
+     * for ex. when the view is moved.
+     */
+    wf::geometry_t box;
+};
+
+/**
+ * name: view-region-damaged
+ * on: output
+ * when: Whenever a region of a view on the output becomes damaged, together
+ *   with the view's region-damaged signal. Lets plugins find out which view
+ *   caused a given damage.
+ */
+struct view_region_damaged_signal : public _view_signal
+{
+    /** The damaged box, in output-local coordinates */
+    wf::geometry_t box;
+};
+
+/**
+ * name: occlusion-changed
+ * on: view, output(view-)
+ * when: Whenever the view becomes fully covered by opaque views above it on
+ *   the current workspace, or stops being fully covered. Fully covered views
+ *   receive throttled frame callbacks, see core/occluded_frame_rate.
+ */
+struct view_occlusion_changed_signal : public _view_signal
+{
+    /** true if the view is now fully occluded */
+    bool occluded;
+};
 
 /**
  * name: decoration-state-updated
@@ -0,0 +1,53 @@
+#ifndef WF_TASK_POOL_HPP
+#define WF_TASK_POOL_HPP
+
+#include <functional>
+#include <memory>
+#include <wayfire/nonstd/noncopyable.hpp>
+
+namespace wf
+{
+/**
+ * A pool of worker threads shared by the whole compositor.
+ *
+ * It is meant for CPU-heavy work which can be split into independent parts,
+ * for example updating particles or physics models. The worker threads are
+ * started once, on first use, and sleep while there is no work, so that
+ * users do not have to create threads on each frame.
+ */
+class task_pool_t : public noncopyable_t
+{
+  public:
+    ~task_pool_t();
+
+    /**
+     * Split the range [0, count) into chunks and call func(start, end) for
+     * each chunk, on the worker threads and on the calling thread. Returns
+     * after all chunks have been processed.
+     *
+     * func must be safe to call concurrently for different chunks. Must be
+     * called from the main thread only, not from inside another task.
+     *
+     * @param count The number of items to process.
+     * @param min_chunk The minimal number of items in a chunk. Workloads
+     *   smaller than this are not split.
+     */
+    void parallel_for(int count, int min_chunk,
+        const std::function<void(int, int)>& func);
+
+    /** @return The number of threads which run tasks, including the caller. */
+    int get_concurrency() const;
+
+  private:
+    task_pool_t();
+    friend task_pool_t& get_task_pool();
+
+    class impl;
+    std::unique_ptr<impl> priv;
+};
+
+/** @return The compositor-wide task pool. */
+task_pool_t& get_task_pool();
+}
+
+#endif /* end of include guard: WF_TASK_POOL_HPP */
@@ -2,6 +2,7 @@
 #define VIEW_HPP
 
 #include <vector>
+#include <type_traits>
 #include <wayfire/nonstd/observer_ptr.h>
 
 #include "wayfire/object.hpp"
@@ -27,6 +28,47 @@ namespace wf
 {
 class output_t;
 
+/**
+ * A non-owning reference to a callable which is called for a sequence of
+ * views. Unlike std::function, it never allocates, so it can be used to walk
+ * views on hot paths.
+ *
+ * The callable may return void or bool. Returning true stops the iteration.
+ * The visitor must not outlive the callable it refers to.
+ */
+class view_visitor_t
+{
+  public:
+    template<class Callable, class = std::enable_if_t<
+            !std::is_same_v<std::decay_t<Callable>, view_visitor_t>>>
+    view_visitor_t(Callable&& callable)
+    {
+        this->data = (void*)&callable;
+        this->call = [] (void *ptr, wayfire_view view) -> bool
+        {
+            auto& callable = *(std::remove_reference_t<Callable>*)ptr;
+            if constexpr (std::is_void_v<decltype(callable(view))>)
+            {
+                callable(view);
+                return false;
+            } else
+            {
+                return callable(view);
+            }
+        };
+    }
+
+    /** @return true if the iteration should stop */
+    bool operator ()(wayfire_view view) const
+    {
+        return call(data, view);
+    }
+
+  private:
+    void *data;
+    bool (*call)(void*, wayfire_view);
+};
+
 /* abstraction for desktop-apis, no real need for plugins
  * This is a base class to all "drawables" - desktop views, subsurfaces, popups */
 enum view_role_t
@@ -78,6 +120,17 @@ class view_interface_t : public surface_interface_t, public wf::object_base_t
      */
     std::vector<wayfire_view> enumerate_views(bool mapped_only = true);
 
+    /**
+     * Visit all views in the view's tree, in the same order as
+     * enumerate_views(), but without building a list.
+     *
+     * @param visitor The callback, it may return true to stop the iteration.
+     * @param mapped_only Whether to include only mapped views.
+     *
+     * @return true if the visitor stopped the iteration.
+     */
+    bool for_each_view(view_visitor_t visitor, bool mapped_only = true);
+
     /**
      * Set the toplevel parent of the view, and adjust the children's list of
      * the parent.
@@ -350,6 +403,8 @@ class view_interface_t : public surface_interface_t, public wf::object_base_t
     void pop_transformer(std::string name);
     /** @return true if the view has active transformers */
     bool has_transformer();
+    /** @return the number of active transformers of the view */
+    size_t get_transformer_count();
 
     /** @return the bounding box of the view up to the given transformer */
     wlr_box get_bounding_box(std::string transformer);
@@ -137,6 +137,18 @@ class workspace_manager
     std::vector<wayfire_view> get_views_on_workspace(wf::point_t ws,
         uint32_t layer_mask);
 
+    /**
+     * Visit the views visible on the given workspace, in the same order as
+     * get_views_on_workspace(), but without building a list.
+     *
+     * The layers must not be modified from inside the visitor.
+     *
+     * @param visitor The callback, it may return true to stop the iteration.
+     * @return true if the visitor stopped the iteration.
+     */
+    bool for_each_view_on_workspace(wf::point_t ws, uint32_t layer_mask,
+        view_visitor_t visitor);
+
     /**
      * Get a list of all views visible on the given workspace and in the given
      * sublayer.
@@ -220,6 +232,17 @@ class workspace_manager
      */
     std::vector<wayfire_view> get_views_in_layer(uint32_t layers_mask);
 
+    /**
+     * Visit the views in the given layers, in the same order as
+     * get_views_in_layer(), but without building a list.
+     *
+     * The layers must not be modified from inside the visitor.
+     *
+     * @param visitor The callback, it may return true to stop the iteration.
+     * @return true if the visitor stopped the iteration.
+     */
+    bool for_each_view_in_layer(uint32_t layers_mask, view_visitor_t visitor);
+
     /**
      * Get a list of reordered fullscreen views as explained in
      * get_views_in_layer().
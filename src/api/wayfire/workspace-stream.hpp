@@ -10,10 +10,17 @@ namespace wf
  * given workspace.  */
 struct workspace_stream_t
 {
+    workspace_stream_t() = default;
+    workspace_stream_t(workspace_stream_t&& other);
+    ~workspace_stream_t();
+
     wf::point_t ws;
     wf::framebuffer_base_t buffer;
     bool running = false;
 
+    /* The scale of the stream buffer relative to the output resolution.
+     * Set by workspace_stream_update(), a plugin may set it before starting
+     * the stream to avoid a full-size first repaint. */
     float scale_x = 1.0;
     float scale_y = 1.0;
 
@@ -28,6 +35,27 @@ struct workspace_stream_t
     wf::color_t background = {0.0f, 0.0f, 0.0f, -1.0f};
 };
 
+/**
+ * Memory statistics for the buffers of the workspace streams on all outputs.
+ *
+ * The buffers are kept within the core/workspace_stream_memory budget by
+ * releasing the least recently used buffers of stopped streams.
+ */
+struct workspace_stream_stats_t
+{
+    /** Number of streams which currently hold a buffer */
+    uint32_t resident_buffers = 0;
+    /** Total size of these buffers, in bytes */
+    uint64_t resident_bytes = 0;
+    /** The configured budget, in bytes */
+    uint64_t budget_bytes = 0;
+    /** Number of buffers released so far to stay within the budget */
+    uint64_t evictions = 0;
+};
+
+/** @return The current workspace stream memory statistics. */
+workspace_stream_stats_t get_workspace_stream_stats();
+
 /**
  * name: workspace-stream-pre, workspace-stream-post
  * on: render-manager
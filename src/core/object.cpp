@@ -1,7 +1,8 @@
 #include "wayfire/object.hpp"
 #include "wayfire/nonstd/safe-list.hpp"
 #include <unordered_map>
-#include <set>
+#include <vector>
+#include <algorithm>
 
 /* Implementation note: because of circular dependencies between
  * signal_connection_t and signal_provider_t, the chosen way to resolve
@@ -12,17 +13,30 @@ class wf::signal_connection_t::impl
 {
   public:
     signal_callback_t callback;
-    std::set<nonstd::observer_ptr<signal_provider_t>> connected_providers;
 
-    void add(signal_provider_t *provider)
+    /**
+     * Where the connection is registered: the provider, the ID of the signal
+     * and the index in the provider's list of connections for that signal.
+     * The provider's entry stores the index of the record in turn, and both
+     * sides keep each other's index up to date, so that neither
+     * disconnecting nor destroying a provider needs to search.
+     */
+    struct record_t
     {
-        connected_providers.insert(provider);
-    }
-
-    void remove(signal_provider_t *provider)
-    {
-        connected_providers.erase(provider);
-    }
+        signal_provider_t *provider;
+        uint32_t signal;
+        size_t index;
+    };
+
+    std::vector<record_t> records;
+
+    /**
+     * The positions in records of the records of each provider. Most
+     * connections have only a few records, so this is built only once there
+     * are many of them (for ex. one connection shared by all views), and
+     * disconnecting from one provider does not scan all records.
+     */
+    std::unordered_map<signal_provider_t*, std::vector<size_t>> by_provider;
 };
 
 wf::signal_connection_t::signal_connection_t()
@@ -48,93 +62,380 @@ void wf::signal_connection_t::emit(signal_data_t *data)
     }
 }
 
-void wf::signal_connection_t::disconnect()
+namespace
+{
+/** Global registry of interned signal names */
+struct signal_registry_t
+{
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<std::string> names;
+};
+
+signal_registry_t& get_signal_registry()
+{
+    static signal_registry_t registry;
+
+    return registry;
+}
+
+/**
+ * @return The ID of the given signal name, or -1 if it has never been
+ *   interned, in which case there can be no listeners for it.
+ */
+int64_t find_signal_id(const std::string& name)
+{
+    auto& registry = get_signal_registry();
+    auto it = registry.ids.find(name);
+
+    return it == registry.ids.end() ? -1 : it->second;
+}
+}
+
+wf::signal_id_t::signal_id_t(const std::string& name)
 {
-    auto connected = this->priv->connected_providers;
-    for (auto& provider : connected)
+    auto& registry = get_signal_registry();
+    auto it = registry.ids.find(name);
+    if (it != registry.ids.end())
     {
-        provider->disconnect_signal(this);
+        this->id = it->second;
+    } else
+    {
+        this->id = registry.names.size();
+        registry.ids[name] = this->id;
+        registry.names.push_back(name);
     }
 }
 
+const std::string& wf::signal_id_t::get_name() const
+{
+    return get_signal_registry().names[id];
+}
+
+/* Number of records after which a connection indexes them by provider */
+static constexpr size_t PROVIDER_INDEX_THRESHOLD = 16;
+
 class wf::signal_provider_t::sprovider_impl
 {
   public:
-    std::unordered_map<std::string,
-        wf::safe_list_t<signal_connection_t*>> signals;
+    /**
+     * A listener registered on a signal, together with the index of the
+     * matching record in the connection, so that either side can find the
+     * other in O(1).
+     */
+    struct slot_t
+    {
+        signal_connection_t *connection;
+        size_t record;
+    };
+
+    struct signal_t
+    {
+        /**
+         * The connected listeners, in connection order. Disconnected
+         * listeners are set to nullptr and removed in batches, so that
+         * disconnecting is O(1) and safe during emission.
+         */
+        std::vector<slot_t> connections;
+        size_t disconnected = 0;
+        int emitting = 0;
+
+        /* Deprecated: */
+        wf::safe_list_t<signal_callback_t*> callbacks;
+    };
+
+    /**
+     * Signals indexed by their interned ID. Entries are created only for
+     * signals which have been connected to on this provider.
+     */
+    std::vector<std::unique_ptr<signal_t>> signals;
+    signal_provider_t *self;
+
+    signal_t& get_or_create(uint32_t id)
+    {
+        if (id >= signals.size())
+        {
+            signals.resize(id + 1);
+        }
+
+        if (!signals[id])
+        {
+            signals[id] = std::make_unique<signal_t>();
+        }
+
+        return *signals[id];
+    }
+
+    using record_t = wf::signal_connection_t::impl::record_t;
+
+    /** @return The slot which the given record points to */
+    static slot_t& get_slot(const record_t& r)
+    {
+        return r.provider->sprovider_priv->signals[r.signal]->connections[
+            r.index];
+    }
+
+    /** Add a record to the connection */
+    static void add_record(signal_connection_t *connection,
+        const record_t& record)
+    {
+        auto& priv = *connection->priv;
+        priv.records.push_back(record);
+        if (!priv.by_provider.empty())
+        {
+            priv.by_provider[record.provider].push_back(
+                priv.records.size() - 1);
+        } else if (priv.records.size() >= PROVIDER_INDEX_THRESHOLD)
+        {
+            for (size_t i = 0; i < priv.records.size(); i++)
+            {
+                priv.by_provider[priv.records[i].provider].push_back(i);
+            }
+        }
+    }
+
+    /**
+     * Remove the record at the given index from the connection, by moving
+     * the last record in its place and updating the slot pointing to it.
+     */
+    static void erase_record(signal_connection_t *connection, size_t index)
+    {
+        auto& priv = *connection->priv;
+        size_t last = priv.records.size() - 1;
+        if (!priv.by_provider.empty())
+        {
+            auto it = priv.by_provider.find(priv.records[index].provider);
+            auto& positions = it->second;
+            *std::find(positions.begin(), positions.end(), index) =
+                positions.back();
+            positions.pop_back();
+            if (positions.empty())
+            {
+                priv.by_provider.erase(it);
+            }
+
+            if (index != last)
+            {
+                auto& moved =
+                    priv.by_provider.find(priv.records[last].provider)->second;
+                *std::find(moved.begin(), moved.end(), last) = index;
+            }
+        }
+
+        if (index != last)
+        {
+            priv.records[index] = priv.records[last];
+            get_slot(priv.records[index]).record = index;
+        }
+
+        priv.records.pop_back();
+    }
+
+    /** Disconnect the connection from the signal of the given record */
+    static void disconnect_record(signal_connection_t *connection, size_t index)
+    {
+        /* Drop the record first: removing may compact the signal, which
+         * updates the records of the remaining connections */
+        auto record = connection->priv->records[index];
+        erase_record(connection, index);
+        record.provider->sprovider_priv->remove_at(record.signal, record.index);
+    }
+
+    /** Disconnect the connection from all signals of this provider */
+    void disconnect(signal_connection_t *connection)
+    {
+        /* Records are removed from the back, so that moving the last record
+         * in place of a removed one never moves a record of this provider
+         * which still has to be visited */
+        auto& priv = *connection->priv;
+        if (priv.by_provider.empty())
+        {
+            for (size_t i = priv.records.size(); i-- > 0;)
+            {
+                if (priv.records[i].provider == self)
+                {
+                    disconnect_record(connection, i);
+                }
+            }
 
-    std::unordered_map<std::string,
-        wf::safe_list_t<signal_callback_t*>> deprecated_signals;
+            return;
+        }
+
+        auto it = priv.by_provider.find(self);
+        if (it == priv.by_provider.end())
+        {
+            return;
+        }
+
+        auto positions = it->second;
+        std::sort(positions.rbegin(), positions.rend());
+        for (auto i : positions)
+        {
+            disconnect_record(connection, i);
+        }
+    }
+
+    /** Remove disconnected listeners, updating the indices of the others */
+    void compact(uint32_t id)
+    {
+        auto& signal = *signals[id];
+        size_t next = 0;
+        for (size_t i = 0; i < signal.connections.size(); i++)
+        {
+            auto slot = signal.connections[i];
+            if (!slot.connection)
+            {
+                continue;
+            }
+
+            if (i != next)
+            {
+                slot.connection->priv->records[slot.record].index = next;
+                signal.connections[next] = slot;
+            }
+
+            ++next;
+        }
+
+        signal.connections.resize(next);
+        signal.disconnected = 0;
+    }
+
+    void remove_at(uint32_t id, size_t index)
+    {
+        auto& signal = *signals[id];
+        signal.connections[index].connection = nullptr;
+        ++signal.disconnected;
+
+        /* Compact once at least half of the entries are gone, which keeps
+         * disconnection amortized O(1) */
+        if (!signal.emitting &&
+            (signal.disconnected * 2 >= signal.connections.size()))
+        {
+            compact(id);
+        }
+    }
+
+    void emit(int64_t id, wf::signal_data_t *data)
+    {
+        if ((id < 0) || (id >= (int64_t)signals.size()) || !signals[id])
+        {
+            return;
+        }
+
+        /* Keep a reference, the vector may be resized by a callback */
+        auto& signal = *signals[id];
+
+        /* Listeners connected during the emission are not called */
+        ++signal.emitting;
+        size_t count = signal.connections.size();
+        for (size_t i = 0; i < count; i++)
+        {
+            if (auto connection = signal.connections[i].connection)
+            {
+                connection->emit(data);
+            }
+        }
+
+        --signal.emitting;
+        if (!signal.emitting && signal.disconnected)
+        {
+            compact(id);
+        }
+
+        /* Deprecated: */
+        signal.callbacks.for_each([data] (auto call)
+        {
+            (*call)(data);
+        });
+    }
 };
 
+void wf::signal_connection_t::disconnect()
+{
+    /* Removing the last record never moves the others */
+    while (!priv->records.empty())
+    {
+        signal_provider_t::sprovider_impl::disconnect_record(this,
+            priv->records.size() - 1);
+    }
+}
+
 wf::signal_provider_t::signal_provider_t()
 {
     this->sprovider_priv = std::make_unique<sprovider_impl>();
+    this->sprovider_priv->self = this;
 }
 
 wf::signal_provider_t::~signal_provider_t()
 {
-    for (auto& s : sprovider_priv->signals)
+    for (auto& signal : sprovider_priv->signals)
     {
-        s.second.for_each([=] (signal_connection_t *connection)
+        if (!signal)
         {
-            connection->priv->remove(this);
-        });
+            continue;
+        }
+
+        for (auto& slot : signal->connections)
+        {
+            if (slot.connection)
+            {
+                sprovider_impl::erase_record(slot.connection, slot.record);
+            }
+        }
     }
 }
 
 void wf::signal_provider_t::connect_signal(std::string name,
     signal_connection_t *callback)
 {
-    sprovider_priv->signals[name].push_back(callback);
-    callback->priv->add(this);
+    connect_signal(signal_id_t{name}, callback);
 }
 
-void wf::signal_provider_t::disconnect_signal(signal_connection_t *connection)
+void wf::signal_provider_t::connect_signal(const signal_id_t& id,
+    signal_connection_t *callback)
 {
-    for (auto& s : sprovider_priv->signals)
-    {
-        s.second.remove_if([=] (signal_connection_t *connected)
-        {
-            if (connected == connection)
-            {
-                connected->priv->remove(this);
-
-                return true;
-            }
+    auto& signal = sprovider_priv->get_or_create(id.get());
+    sprovider_impl::add_record(callback, {this, id.get(),
+        signal.connections.size()});
+    signal.connections.push_back({callback,
+        callback->priv->records.size() - 1});
+}
 
-            return false;
-        });
-    }
+void wf::signal_provider_t::disconnect_signal(signal_connection_t *connection)
+{
+    sprovider_priv->disconnect(connection);
 }
 
 /* Deprecated: */
 void wf::signal_provider_t::connect_signal(std::string name,
     signal_callback_t *callback)
 {
-    sprovider_priv->deprecated_signals[name].push_back(callback);
+    sprovider_priv->get_or_create(signal_id_t{name}.get()).callbacks.push_back(
+        callback);
 }
 
 /* Deprecated: */
 void wf::signal_provider_t::disconnect_signal(std::string name,
     signal_callback_t *callback)
 {
-    sprovider_priv->deprecated_signals[name].remove_all(callback);
+    auto id = find_signal_id(name);
+    if ((id >= 0) && (id < (int64_t)sprovider_priv->signals.size()) &&
+        sprovider_priv->signals[id])
+    {
+        sprovider_priv->signals[id]->callbacks.remove_all(callback);
+    }
 }
 
 /* Emit the given signal. No type checking for data is required */
 void wf::signal_provider_t::emit_signal(std::string name, wf::signal_data_t *data)
 {
-    sprovider_priv->signals[name].for_each([data] (auto call)
-    {
-        call->emit(data);
-    });
+    sprovider_priv->emit(find_signal_id(name), data);
+}
 
-    /* Deprecated: */
-    sprovider_priv->deprecated_signals[name].for_each([data] (auto call)
-    {
-        (*call)(data);
-    });
+void wf::signal_provider_t::emit_signal(const signal_id_t& id,
+    wf::signal_data_t *data)
+{
+    sprovider_priv->emit(id.get(), data);
 }
 
 class wf::object_base_t::obase_impl
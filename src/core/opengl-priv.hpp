@@ -14,6 +14,8 @@ void fini();
 void bind_output(wf::output_t *output, uint32_t fb);
 /** Indicate the output frame has been finished */
 void unbind_output(wf::output_t *output);
+/** Reset the counter returned by get_draw_call_count() */
+void reset_draw_call_count();
 }
 
 #endif /* end of include guard: WF_OPENGL_PRIV_HPP */
@@ -1,8 +1,13 @@
 #include <wayfire/util/log.hpp>
 #include <map>
+#include <unordered_map>
+#include <array>
+#include <algorithm>
+#include <tuple>
 #include "opengl-priv.hpp"
 #include "wayfire/output.hpp"
 #include "core-impl.hpp"
+#include "../main.hpp"
 #include "config.h"
 
 extern "C"
@@ -100,6 +105,22 @@ GLuint compile_program(std::string vertex_source, std::string frag_source)
     return result_program;
 }
 
+namespace
+{
+/* Cached uniform and attribute handles of the default programs */
+struct
+{
+    program_t::attrib_t position, uv_position;
+    program_t::uniform_t mvp, color;
+} texture_locs;
+
+struct
+{
+    program_t::attrib_t position;
+    program_t::uniform_t mvp, color;
+} color_locs;
+}
+
 void init()
 {
     render_begin();
@@ -110,21 +131,53 @@ void init()
     color_program.set_simple(compile_program(default_vertex_shader_source,
         color_rect_fragment_source));
 
+    texture_locs.position    = program.get_attrib("position");
+    texture_locs.uv_position = program.get_attrib("uvPosition");
+    texture_locs.mvp   = program.get_uniform("MVP");
+    texture_locs.color = program.get_uniform("color");
+
+    color_locs.position = color_program.get_attrib("position");
+    color_locs.mvp   = color_program.get_uniform("MVP");
+    color_locs.color = color_program.get_uniform("color");
+
     render_end();
 }
 
+namespace
+{
+wf::output_t *current_output = NULL;
+uint32_t current_output_fb   = 0;
+
+/* Number of draw calls issued since the last reset_draw_call_count() */
+uint32_t draw_call_count = 0;
+
+/* Vertex buffer and staging area for batched texture rendering */
+GLuint batch_vbo = 0;
+std::vector<GLfloat> batch_vertices;
+}
+
 void fini()
 {
     render_begin();
     program.free_resources();
     color_program.free_resources();
+    if (batch_vbo)
+    {
+        GL_CALL(glDeleteBuffers(1, &batch_vbo));
+        batch_vbo = 0;
+    }
+
     render_end();
 }
 
-namespace
+uint32_t get_draw_call_count()
 {
-wf::output_t *current_output = NULL;
-uint32_t current_output_fb   = 0;
+    return draw_call_count;
+}
+
+void reset_draw_call_count()
+{
+    draw_call_count = 0;
 }
 
 void bind_output(wf::output_t *output, uint32_t fb)
@@ -183,14 +236,15 @@ void render_transformed_texture(wf::texture_t tex,
     }
 
     program.set_active_texture(tex);
-    program.attrib_pointer("position", 2, 0, vertexData);
-    program.attrib_pointer("uvPosition", 2, 0, coordData);
-    program.uniformMatrix4f("MVP", model);
-    program.uniform4f("color", color);
+    program.attrib_pointer(texture_locs.position, 2, 0, vertexData);
+    program.attrib_pointer(texture_locs.uv_position, 2, 0, coordData);
+    program.uniformMatrix4f(texture_locs.mvp, model);
+    program.uniform4f(texture_locs.color, color);
 
     GL_CALL(glEnable(GL_BLEND));
     GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
     GL_CALL(glDrawArrays(GL_TRIANGLE_FAN, 0, 4));
+    ++draw_call_count;
 
     program.deactivate();
 }
@@ -217,6 +271,102 @@ void render_texture(wf::texture_t texture,
         framebuffer.get_orthographic_projection(), color, bits);
 }
 
+void render_texture(wf::texture_t texture,
+    const wf::framebuffer_t& framebuffer,
+    const wf::geometry_t& geometry, const wf::region_t& damage,
+    glm::vec4 color, uint32_t bits)
+{
+    if (runtime_config.no_batched_render)
+    {
+        for (const auto& rect : damage)
+        {
+            framebuffer.logic_scissor(wlr_box_from_pixman_box(rect));
+            render_texture(texture, framebuffer, geometry, color, bits);
+        }
+
+        return;
+    }
+
+    /* Clip the quad to each damaged rectangle, so that we don't need to
+     * scissor and can draw everything at once. Each rectangle is two triangles,
+     * each vertex consists of its position and texture coordinates. */
+    batch_vertices.clear();
+    const float x1 = geometry.x, y1 = geometry.y;
+    const float x2 = x1 + geometry.width, y2 = y1 + geometry.height;
+    for (const auto& rect : damage)
+    {
+        float cx1 = std::max<float>(rect.x1, x1);
+        float cy1 = std::max<float>(rect.y1, y1);
+        float cx2 = std::min<float>(rect.x2, x2);
+        float cy2 = std::min<float>(rect.y2, y2);
+        if ((cx1 >= cx2) || (cy1 >= cy2))
+        {
+            continue;
+        }
+
+        /* Same texture coordinates as in render_transformed_texture(),
+         * i.e v = 0 is at the bottom of the quad. */
+        auto push_vertex = [&] (float x, float y)
+        {
+            float u = (x - x1) / geometry.width;
+            float v = (y2 - y) / geometry.height;
+            if (bits & TEXTURE_TRANSFORM_INVERT_X)
+            {
+                u = 1.0f - u;
+            }
+
+            if (bits & TEXTURE_TRANSFORM_INVERT_Y)
+            {
+                v = 1.0f - v;
+            }
+
+            batch_vertices.insert(batch_vertices.end(), {x, y, u, v});
+        };
+
+        push_vertex(cx1, cy2);
+        push_vertex(cx2, cy2);
+        push_vertex(cx2, cy1);
+        push_vertex(cx2, cy1);
+        push_vertex(cx1, cy1);
+        push_vertex(cx1, cy2);
+    }
+
+    if (batch_vertices.empty())
+    {
+        return;
+    }
+
+    if (!batch_vbo)
+    {
+        GL_CALL(glGenBuffers(1, &batch_vbo));
+    }
+
+    program.use(texture.type);
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, batch_vbo));
+    GL_CALL(glBufferData(GL_ARRAY_BUFFER,
+        batch_vertices.size() * sizeof(GLfloat), batch_vertices.data(),
+        GL_STREAM_DRAW));
+
+    const int stride = 4 * sizeof(GLfloat);
+    program.set_active_texture(texture);
+    program.attrib_pointer(texture_locs.position, 2, stride, (void*)0);
+    program.attrib_pointer(texture_locs.uv_position, 2, stride,
+        (void*)(2 * sizeof(GLfloat)));
+    program.uniformMatrix4f(texture_locs.mvp,
+        framebuffer.get_orthographic_projection());
+    program.uniform4f(texture_locs.color, color);
+
+    GL_CALL(glDisable(GL_SCISSOR_TEST));
+    GL_CALL(glEnable(GL_BLEND));
+    GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+    GL_CALL(glDrawArrays(GL_TRIANGLES, 0, batch_vertices.size() / 4));
+    ++draw_call_count;
+
+    /* Other helpers use client-side vertex arrays */
+    GL_CALL(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    program.deactivate();
+}
+
 void render_rectangle(wf::geometry_t geometry, wf::color_t color,
     glm::mat4 matrix)
 {
@@ -231,13 +381,15 @@ void render_rectangle(wf::geometry_t geometry, wf::color_t color,
         x, y,
     };
 
-    color_program.attrib_pointer("position", 2, 0, vertexData);
-    color_program.uniformMatrix4f("MVP", matrix);
-    color_program.uniform4f("color", {color.r, color.g, color.b, color.a});
+    color_program.attrib_pointer(color_locs.position, 2, 0, vertexData);
+    color_program.uniformMatrix4f(color_locs.mvp, matrix);
+    color_program.uniform4f(color_locs.color,
+        {color.r, color.g, color.b, color.a});
 
     GL_CALL(glEnable(GL_BLEND));
     GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
     GL_CALL(glDrawArrays(GL_TRIANGLE_FAN, 0, 4));
+    ++draw_call_count;
 
     color_program.deactivate();
 }
@@ -548,43 +700,101 @@ namespace OpenGL
 class program_t::impl
 {
   public:
-    std::set<int> active_attrs;
-    std::set<int> active_attrs_divisors;
+    std::vector<int> active_attrs;
+    std::vector<int> active_attrs_divisors;
 
     int active_program_idx = 0;
 
     int id[wf::TEXTURE_TYPE_ALL];
-    std::map<std::string, int> uniforms[wf::TEXTURE_TYPE_ALL];
 
-    /** Find the uniform location for the currently bound program */
-    int find_uniform_loc(const std::string& name)
+    /**
+     * The names of all uniforms or attributes for which a handle has been
+     * requested, and their locations in the program for each texture type.
+     * A handle is simply an index in these arrays. Lookups by name go
+     * through the index map, string-based calls still hash the name once.
+     */
+    struct location_table_t
+    {
+        std::vector<std::string> names;
+        std::vector<std::array<int, wf::TEXTURE_TYPE_ALL>> locations;
+        std::unordered_map<std::string, int> index;
+    };
+
+    location_table_t uniforms;
+    location_table_t attribs;
+
+    /** Handles for the builtin uniforms used by set_active_texture() */
+    uniform_t y_base, y_mult;
+
+    void resolve(location_table_t& table, size_t idx, bool uniform)
     {
-        auto it = uniforms[active_program_idx].find(name);
-        if (it != uniforms[active_program_idx].end())
+        for (int i = 0; i < wf::TEXTURE_TYPE_ALL; i++)
         {
-            return it->second;
+            int& loc = table.locations[idx][i];
+            if (id[i] == 0)
+            {
+                loc = -1;
+            } else if (uniform)
+            {
+                loc = GL_CALL(glGetUniformLocation(id[i],
+                    table.names[idx].c_str()));
+            } else
+            {
+                loc = GL_CALL(glGetAttribLocation(id[i],
+                    table.names[idx].c_str()));
+            }
         }
+    }
 
-        uniforms[active_program_idx][name] =
-            GL_CALL(glGetUniformLocation(id[active_program_idx], name.c_str()));
+    /** Resolve all handles again, needed after the programs change */
+    void resolve_all()
+    {
+        for (size_t i = 0; i < uniforms.names.size(); i++)
+        {
+            resolve(uniforms, i, true);
+        }
 
-        return uniforms[active_program_idx][name];
+        for (size_t i = 0; i < attribs.names.size(); i++)
+        {
+            resolve(attribs, i, false);
+        }
     }
 
-    std::map<std::string, int> attribs[wf::TEXTURE_TYPE_ALL];
-    /** Find the attrib location for the currently bound program */
-    int find_attrib_loc(const std::string& name)
+    /** Find the index of the given name in the table, adding it if needed */
+    int find_index(location_table_t& table, const std::string& name,
+        bool uniform)
     {
-        auto it = attribs[active_program_idx].find(name);
-        if (it != attribs[active_program_idx].end())
+        auto it = table.index.find(name);
+        if (it != table.index.end())
         {
             return it->second;
         }
 
-        attribs[active_program_idx][name] =
-            GL_CALL(glGetAttribLocation(id[active_program_idx], name.c_str()));
+        table.index[name] = table.names.size();
+        table.names.push_back(name);
+        table.locations.emplace_back();
+        resolve(table, table.names.size() - 1, uniform);
+
+        return table.names.size() - 1;
+    }
+
+    /** Get the location of a handle in the currently bound program */
+    int get_location(const location_table_t& table, int index)
+    {
+        if ((index < 0) || (index >= (int)table.locations.size()))
+        {
+            return -1;
+        }
+
+        return table.locations[index][active_program_idx];
+    }
 
-        return attribs[active_program_idx][name];
+    void mark_active(std::vector<int>& active, int loc)
+    {
+        if (std::find(active.begin(), active.end(), loc) == active.end())
+        {
+            active.push_back(loc);
+        }
     }
 };
 
@@ -595,6 +805,10 @@ program_t::program_t()
     {
         this->priv->id[i] = 0;
     }
+
+    /* No programs yet, so this doesn't need a GL context */
+    priv->y_base = get_uniform("_wayfire_y_base");
+    priv->y_mult = get_uniform("_wayfire_y_mult");
 }
 
 void program_t::set_simple(GLuint program_id, wf::texture_type_t type)
@@ -602,6 +816,7 @@ void program_t::set_simple(GLuint program_id, wf::texture_type_t type)
     free_resources();
     assert(type < wf::TEXTURE_TYPE_ALL);
     this->priv->id[type] = program_id;
+    priv->resolve_all();
 }
 
 program_t::~program_t()
@@ -648,6 +863,8 @@ void program_t::compile(const std::string& vertex_source,
         this->priv->id[program_type.first] =
             compile_program(vertex_source, fragment);
     }
+
+    priv->resolve_all();
 }
 
 void program_t::free_resources()
@@ -679,50 +896,105 @@ int program_t::get_program_id(wf::texture_type_t type)
     return priv->id[type];
 }
 
+program_t::uniform_t program_t::get_uniform(const std::string& name)
+{
+    return {priv->find_index(priv->uniforms, name, true)};
+}
+
+program_t::attrib_t program_t::get_attrib(const std::string& name)
+{
+    return {priv->find_index(priv->attribs, name, false)};
+}
+
 void program_t::uniform1i(const std::string& name, int value)
 {
-    int loc = priv->find_uniform_loc(name);
-    GL_CALL(glUniform1i(loc, value));
+    uniform1i(get_uniform(name), value);
 }
 
 void program_t::uniform1f(const std::string& name, float value)
 {
-    int loc = priv->find_uniform_loc(name);
-    GL_CALL(glUniform1f(loc, value));
+    uniform1f(get_uniform(name), value);
 }
 
 void program_t::uniform2f(const std::string& name, float x, float y)
 {
-    int loc = priv->find_uniform_loc(name);
-    GL_CALL(glUniform2f(loc, x, y));
+    uniform2f(get_uniform(name), x, y);
 }
 
 void program_t::uniform4f(const std::string& name, const glm::vec4& value)
 {
-    int loc = priv->find_uniform_loc(name);
-    GL_CALL(glUniform4f(loc, value.r, value.g, value.b, value.a));
+    uniform4f(get_uniform(name), value);
 }
 
 void program_t::uniformMatrix4f(const std::string& name, const glm::mat4& value)
 {
-    int loc = priv->find_uniform_loc(name);
-    GL_CALL(glUniformMatrix4fv(loc, 1, GL_FALSE, &value[0][0]));
+    uniformMatrix4f(get_uniform(name), value);
 }
 
 void program_t::attrib_pointer(const std::string& attrib,
     int size, int stride, const void *ptr, GLenum type)
 {
-    int loc = priv->find_attrib_loc(attrib);
-    priv->active_attrs.insert(loc);
+    attrib_pointer(get_attrib(attrib), size, stride, ptr, type);
+}
+
+void program_t::attrib_divisor(const std::string& attrib, int divisor)
+{
+    attrib_divisor(get_attrib(attrib), divisor);
+}
+
+void program_t::uniform1i(uniform_t uniform, int value)
+{
+    int loc = priv->get_location(priv->uniforms, uniform.index);
+    GL_CALL(glUniform1i(loc, value));
+}
+
+void program_t::uniform1f(uniform_t uniform, float value)
+{
+    int loc = priv->get_location(priv->uniforms, uniform.index);
+    GL_CALL(glUniform1f(loc, value));
+}
+
+void program_t::uniform2f(uniform_t uniform, float x, float y)
+{
+    int loc = priv->get_location(priv->uniforms, uniform.index);
+    GL_CALL(glUniform2f(loc, x, y));
+}
+
+void program_t::uniform4f(uniform_t uniform, const glm::vec4& value)
+{
+    int loc = priv->get_location(priv->uniforms, uniform.index);
+    GL_CALL(glUniform4f(loc, value.r, value.g, value.b, value.a));
+}
+
+void program_t::uniformMatrix4f(uniform_t uniform, const glm::mat4& value)
+{
+    int loc = priv->get_location(priv->uniforms, uniform.index);
+    GL_CALL(glUniformMatrix4fv(loc, 1, GL_FALSE, &value[0][0]));
+}
+
+void program_t::attrib_pointer(attrib_t attrib,
+    int size, int stride, const void *ptr, GLenum type)
+{
+    int loc = priv->get_location(priv->attribs, attrib.index);
+    if (loc < 0)
+    {
+        return;
+    }
 
+    priv->mark_active(priv->active_attrs, loc);
     GL_CALL(glEnableVertexAttribArray(loc));
     GL_CALL(glVertexAttribPointer(loc, size, type, GL_FALSE, stride, ptr));
 }
 
-void program_t::attrib_divisor(const std::string& attrib, int divisor)
+void program_t::attrib_divisor(attrib_t attrib, int divisor)
 {
-    int loc = priv->find_attrib_loc(attrib);
-    priv->active_attrs_divisors.insert(loc);
+    int loc = priv->get_location(priv->attribs, attrib.index);
+    if (loc < 0)
+    {
+        return;
+    }
+
+    priv->mark_active(priv->active_attrs_divisors, loc);
     GL_CALL(glVertexAttribDivisor(loc, divisor));
 }
 
@@ -732,8 +1004,8 @@ void program_t::set_active_texture(const wf::texture_t& texture)
     GL_CALL(glBindTexture(texture.target, texture.tex_id));
     GL_CALL(glTexParameteri(texture.target, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
 
-    uniform1f("_wayfire_y_base", texture.invert_y ? 1 : 0);
-    uniform1f("_wayfire_y_mult", texture.invert_y ? -1 : 1);
+    uniform1f(priv->y_base, texture.invert_y ? 1 : 0);
+    uniform1f(priv->y_mult, texture.invert_y ? -1 : 1);
 }
 
 void program_t::deactivate()
@@ -752,4 +1024,80 @@ void program_t::deactivate()
     priv->active_attrs.clear();
     GL_CALL(glUseProgram(0));
 }
+
+namespace
+{
+struct shared_program_key_t
+{
+    bool simple;
+    std::string vertex_source;
+    std::string fragment_source;
+
+    bool operator <(const shared_program_key_t& other) const
+    {
+        return std::tie(simple, vertex_source, fragment_source) <
+               std::tie(other.simple, other.vertex_source, other.fragment_source);
+    }
+};
+
+/* Programs which are currently in use, by their sources */
+std::map<shared_program_key_t, std::weak_ptr<program_t>> shared_programs;
+
+std::shared_ptr<program_t> find_or_compile_program(shared_program_key_t key)
+{
+    auto it = shared_programs.find(key);
+    if (it != shared_programs.end())
+    {
+        if (auto program = it->second.lock())
+        {
+            return program;
+        }
+    }
+
+    auto program = new program_t();
+    OpenGL::render_begin();
+    if (key.simple)
+    {
+        program->set_simple(
+            compile_program(key.vertex_source, key.fragment_source));
+    } else
+    {
+        program->compile(key.vertex_source, key.fragment_source);
+    }
+
+    OpenGL::render_end();
+
+    std::shared_ptr<program_t> shared{program, [key] (program_t *program)
+        {
+            OpenGL::render_begin();
+            program->free_resources();
+            OpenGL::render_end();
+            delete program;
+
+            /* The entry may already point to a new instance of the program */
+            auto it = shared_programs.find(key);
+            if ((it != shared_programs.end()) && it->second.expired())
+            {
+                shared_programs.erase(it);
+            }
+        }
+    };
+
+    shared_programs[key] = shared;
+
+    return shared;
+}
+}
+
+std::shared_ptr<program_t> get_shared_program(
+    const std::string& vertex_source, const std::string& fragment_source)
+{
+    return find_or_compile_program({false, vertex_source, fragment_source});
+}
+
+std::shared_ptr<program_t> get_shared_simple_program(
+    const std::string& vertex_source, const std::string& fragment_source)
+{
+    return find_or_compile_program({true, vertex_source, fragment_source});
+}
 }
@@ -1,5 +1,7 @@
 #include <cassert>
 #include <algorithm>
+#include <sstream>
+#include <tuple>
 #include "surface-map-state.hpp"
 
 extern "C"
@@ -10,6 +12,7 @@ extern "C"
 #include "wayfire/signal-definitions.hpp"
 #include "../core-impl.hpp"
 #include "../../output/output-impl.hpp"
+#include "../../main.hpp"
 #include "touch.hpp"
 #include "keyboard.hpp"
 #include "cursor.hpp"
@@ -323,22 +326,53 @@ wf::surface_interface_t*input_manager::input_surface_at(wf::pointf_t global,
     global.x -= og.x;
     global.y -= og.y;
 
-    for (auto& v : output->workspace->get_views_in_layer(wf::VISIBLE_LAYERS))
+    wf::surface_interface_t *result = nullptr;
+    auto impl = (wf::output_impl_t*)output;
+    impl->input_index->for_each_view_at(global, [&] (wayfire_view view)
     {
-        for (auto& view : v->enumerate_views())
+        if (!view->minimized && can_focus_surface(view.get()))
         {
-            if (!view->minimized && can_focus_surface(view.get()))
-            {
-                auto surface = view->map_input_coordinates(global, local);
-                if (surface)
-                {
-                    return surface;
-                }
-            }
+            result = view->map_input_coordinates(global, local);
+        }
+
+        return result != nullptr;
+    });
+
+    if (runtime_config.input_debug)
+    {
+        wf::pointf_t scan_local;
+        auto expected = scan_surface_at(output, global, scan_local);
+        if (expected != result)
+        {
+            LOGE("Input index returned ", result, " instead of ", expected,
+                " at ", global, " on output ", output->to_string());
+            local = scan_local;
+
+            return expected;
         }
     }
 
-    return nullptr;
+    return result;
+}
+
+wf::surface_interface_t*input_manager::scan_surface_at(wf::output_t *output,
+    wf::pointf_t point, wf::pointf_t& local)
+{
+    wf::surface_interface_t *result = nullptr;
+    auto check_view = [&] (wayfire_view view)
+    {
+        if (!view->minimized && can_focus_surface(view.get()))
+        {
+            result = view->map_input_coordinates(point, local);
+        }
+
+        return result != nullptr;
+    };
+
+    output->workspace->for_each_view_in_layer(wf::VISIBLE_LAYERS,
+        [&] (wayfire_view v) { return v->for_each_view(check_view); });
+
+    return result;
 }
 
 void input_manager::set_exclusive_focus(wl_client *client)
@@ -378,8 +412,21 @@ wf::binding_t*input_manager::new_binding(wf_binding_type type,
     binding->value    = value;
     binding->output   = output;
     binding->call.raw = callback;
+    binding->serial   = binding_serial++;
 
     auto raw = binding.get();
+    if ((type == WF_BINDING_KEY) || (type == WF_BINDING_BUTTON) ||
+        (type == WF_BINDING_ACTIVATOR))
+    {
+        index_binding(raw);
+        raw->on_value_changed = [=] ()
+        {
+            unindex_binding(raw);
+            index_binding(raw);
+        };
+        value->add_updated_handler(&raw->on_value_changed);
+    }
+
     bindings[type].push_back(std::move(binding));
 
     return raw;
@@ -395,6 +442,12 @@ void input_manager::rem_binding(binding_criteria criteria)
         {
             if (criteria((*it).get()))
             {
+                if ((*it)->on_value_changed)
+                {
+                    (*it)->value->rem_updated_handler(&(*it)->on_value_changed);
+                    unindex_binding(it->get());
+                }
+
                 it = container.erase(it);
             } else
             {
@@ -422,44 +475,130 @@ void input_manager::free_output_bindings(wf::output_t *output)
     });
 }
 
-bool input_manager::check_button_bindings(uint32_t button)
+/** The order in which bindings for the same input are called */
+static bool binding_call_order(const wf::binding_t *a, const wf::binding_t *b)
 {
-    std::vector<std::function<bool()>> callbacks;
+    bool a_activator = (a->type == WF_BINDING_ACTIVATOR);
+    bool b_activator = (b->type == WF_BINDING_ACTIVATOR);
 
-    auto oc = wf::get_core().get_active_output()->get_cursor_position();
-    auto mod_state = get_modifiers();
+    return std::tie(a_activator, a->serial) < std::tie(b_activator, b->serial);
+}
 
-    for (auto& binding : bindings[WF_BINDING_BUTTON])
+void input_manager::index_binding(wf::binding_t *binding)
+{
+    auto add = [&] (uint32_t modifiers, uint32_t code, bool button)
+    {
+        wf_binding_index_key key{binding->output, modifiers, code, button};
+        auto& list = binding_index[key];
+        list.insert(std::upper_bound(list.begin(), list.end(), binding,
+            binding_call_order), binding);
+        binding->index_keys.push_back(key);
+    };
+
+    if (binding->type == WF_BINDING_KEY)
+    {
+        auto as_key = std::dynamic_pointer_cast<
+            wf::config::option_t<wf::keybinding_t>>(binding->value);
+        assert(as_key);
+
+        auto key = as_key->get_value();
+        add(key.get_modifiers(), key.get_key(), false);
+    } else if (binding->type == WF_BINDING_BUTTON)
     {
         auto as_button = std::dynamic_pointer_cast<
             wf::config::option_t<wf::buttonbinding_t>>(binding->value);
         assert(as_button);
 
-        if ((binding->output == wf::get_core().get_active_output()) &&
-            (wf::buttonbinding_t{mod_state, button} == as_button->get_value()))
+        auto button = as_button->get_value();
+        add(button.get_modifiers(), button.get_button(), true);
+    } else if (binding->type == WF_BINDING_ACTIVATOR)
+    {
+        auto as_activator = std::dynamic_pointer_cast<
+            wf::config::option_t<wf::activatorbinding_t>>(binding->value);
+        assert(as_activator);
+
+        /* activatorbinding_t does not expose its bindings, so they are read
+         * back from its string form. Gestures are not indexed, since they are
+         * handled separately. */
+        std::stringstream stream(
+            wf::option_type::to_string(as_activator->get_value()));
+        std::string part;
+        while (std::getline(stream, part, '|'))
         {
-            /* We must be careful because the callback might be erased,
-             * so force copy the callback into the lambda */
-            auto callback = binding->call.button;
-            callbacks.push_back([=] ()
+            part.erase(0, part.find_first_not_of(' '));
+            part.erase(part.find_last_not_of(' ') + 1);
+
+            if (auto key = wf::option_type::from_string<wf::keybinding_t>(part))
             {
-                return (*callback)(button, oc.x, oc.y);
-            });
+                add(key->get_modifiers(), key->get_key(), false);
+            }
+
+            if (auto button =
+                    wf::option_type::from_string<wf::buttonbinding_t>(part))
+            {
+                add(button->get_modifiers(), button->get_button(), true);
+            }
         }
     }
+}
 
-    for (auto& binding : bindings[WF_BINDING_ACTIVATOR])
+void input_manager::unindex_binding(wf::binding_t *binding)
+{
+    for (auto& key : binding->index_keys)
     {
-        auto as_activator = std::dynamic_pointer_cast<
-            wf::config::option_t<wf::activatorbinding_t>>(binding->value);
-        assert(as_activator);
+        auto it = binding_index.find(key);
+        if (it == binding_index.end())
+        {
+            continue;
+        }
 
-        if ((binding->output == wf::get_core().get_active_output()) &&
-            as_activator->get_value().has_match(
-                wf::buttonbinding_t{mod_state, button}))
+        auto& list = it->second;
+        list.erase(std::remove(list.begin(), list.end(), binding), list.end());
+        if (list.empty())
+        {
+            binding_index.erase(it);
+        }
+    }
+
+    binding->index_keys.clear();
+}
+
+const std::vector<wf::binding_t*>*input_manager::find_bindings(
+    const wf_binding_index_key& key) const
+{
+    auto it = binding_index.find(key);
+    if (it == binding_index.end())
+    {
+        return nullptr;
+    }
+
+    return &it->second;
+}
+
+bool input_manager::check_button_bindings(uint32_t button)
+{
+    auto output = wf::get_core().get_active_output();
+    auto matching = find_bindings({output, get_modifiers(), button, true});
+    if (!matching)
+    {
+        return false;
+    }
+
+    std::vector<std::function<bool()>> callbacks;
+    auto oc = output->get_cursor_position();
+    for (auto& binding : *matching)
+    {
+        /* We must be careful because the callback might be erased,
+         * so force copy the callback into the lambda */
+        if (binding->type == WF_BINDING_BUTTON)
+        {
+            auto callback = binding->call.button;
+            callbacks.push_back([=] ()
+            {
+                return (*callback)(button, oc.x, oc.y);
+            });
+        } else
         {
-            /* We must be careful because the callback might be erased,
-             * so force copy the callback into the lambda */
             auto callback = binding->call.activator;
             callbacks.push_back([=] ()
             {
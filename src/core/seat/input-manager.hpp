@@ -4,6 +4,7 @@
 #include <map>
 #include <vector>
 #include <chrono>
+#include <unordered_map>
 
 #include "seat.hpp"
 #include "cursor.hpp"
@@ -51,12 +52,51 @@ enum wf_binding_type
     WF_BINDING_ACTIVATOR,
 };
 
+/**
+ * A key in the binding index: the output, the modifiers and the key or button
+ * which trigger a binding.
+ */
+struct wf_binding_index_key
+{
+    wf::output_t *output;
+    uint32_t modifiers;
+    uint32_t code;
+    /* Whether code is a pointer button, or a keyboard key */
+    bool button;
+
+    bool operator ==(const wf_binding_index_key& other) const
+    {
+        return output == other.output && modifiers == other.modifiers &&
+               code == other.code && button == other.button;
+    }
+};
+
+struct wf_binding_index_hash
+{
+    size_t operator ()(const wf_binding_index_key& key) const
+    {
+        size_t hash = std::hash<wf::output_t*>()(key.output);
+        hash = hash * 31 + key.modifiers;
+        hash = hash * 31 + key.code;
+
+        return hash * 2 + key.button;
+    }
+};
+
 struct wf::binding_t
 {
     std::shared_ptr<wf::config::option_base_t> value;
     wf_binding_type type;
     wf::output_t *output;
 
+    /* Bindings triggered by the same input are called in the order they were
+     * added, as given by the serial */
+    uint64_t serial;
+    /* The entries for the binding in input_manager's binding index */
+    std::vector<wf_binding_index_key> index_keys;
+    /* Updates the binding index when the option changes */
+    wf::config::option_base_t::updated_callback_t on_value_changed;
+
     union
     {
         void *raw;
@@ -90,6 +130,24 @@ class input_manager
     using binding_criteria = std::function<bool (wf::binding_t*)>;
     void rem_binding(binding_criteria criteria);
 
+    /**
+     * The key, button and activator bindings by the input which triggers
+     * them, so that an input event does not need to check every binding.
+     * Each list is in the order the bindings are called: key or button
+     * bindings first, and then activator bindings.
+     */
+    std::unordered_map<wf_binding_index_key, std::vector<wf::binding_t*>,
+        wf_binding_index_hash> binding_index;
+    uint64_t binding_serial = 0;
+
+    /** Add the binding to the index, with the current value of its option */
+    void index_binding(wf::binding_t *binding);
+    /** Remove the binding from the index */
+    void unindex_binding(wf::binding_t *binding);
+    /** @return The bindings for the given input, or nullptr if there are none */
+    const std::vector<wf::binding_t*> *find_bindings(
+        const wf_binding_index_key& key) const;
+
     void create_seat();
 
     void validate_drag_request(wlr_seat_request_start_drag_event *ev);
@@ -153,6 +211,13 @@ class input_manager
     wf::surface_interface_t *input_surface_at(wf::pointf_t global,
         wf::pointf_t& local);
 
+    /**
+     * Find the surface at the given output-local point by scanning all views
+     * on the output. Used to cross-check the input index in debug mode.
+     */
+    wf::surface_interface_t *scan_surface_at(wf::output_t *output,
+        wf::pointf_t point, wf::pointf_t& local);
+
     uint32_t get_modifiers();
     uint32_t locked_mods = 0;
 
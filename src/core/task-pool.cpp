@@ -0,0 +1,153 @@
+#include <wayfire/task-pool.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+/* A single call to parallel_for(). Shared with the workers, so that a
+ * worker which wakes up late never touches a finished job's state. */
+struct job_t
+{
+    std::function<void(int, int)> func;
+    int count;
+    int chunk_size;
+    int num_chunks;
+
+    std::atomic<int> next_chunk{0};
+    std::atomic<int> remaining;
+
+    std::mutex done_mutex;
+    std::condition_variable done;
+
+    /* Process chunks until there are none left */
+    void run()
+    {
+        int chunk;
+        while ((chunk = next_chunk.fetch_add(1)) < num_chunks)
+        {
+            int start = chunk * chunk_size;
+            func(start, std::min(count, start + chunk_size));
+
+            if (remaining.fetch_sub(1) == 1)
+            {
+                std::lock_guard<std::mutex> lock(done_mutex);
+                done.notify_all();
+            }
+        }
+    }
+};
+}
+
+class wf::task_pool_t::impl
+{
+  public:
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::shared_ptr<job_t> current_job;
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    void worker_loop()
+    {
+        uint64_t seen = 0;
+        while (true)
+        {
+            std::shared_ptr<job_t> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&] { return stopping || (generation != seen); });
+                if (stopping)
+                {
+                    return;
+                }
+
+                seen = generation;
+                job  = current_job;
+            }
+
+            job->run();
+        }
+    }
+};
+
+wf::task_pool_t::task_pool_t()
+{
+    priv = std::make_unique<impl>();
+
+    /* The calling thread also runs tasks */
+    int num_workers = (int)std::thread::hardware_concurrency() - 1;
+    for (int i = 0; i < num_workers; i++)
+    {
+        priv->workers.emplace_back([this] () { priv->worker_loop(); });
+    }
+}
+
+wf::task_pool_t::~task_pool_t()
+{
+    {
+        std::lock_guard<std::mutex> lock(priv->mutex);
+        priv->stopping = true;
+    }
+
+    priv->wake.notify_all();
+    for (auto& worker : priv->workers)
+    {
+        worker.join();
+    }
+}
+
+int wf::task_pool_t::get_concurrency() const
+{
+    return priv->workers.size() + 1;
+}
+
+void wf::task_pool_t::parallel_for(int count, int min_chunk,
+    const std::function<void(int, int)>& func)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+
+    /* A few chunks per thread balance the load when some threads are busy
+     * with other work */
+    int num_chunks = std::min(count / std::max(min_chunk, 1),
+        4 * get_concurrency());
+    if (num_chunks <= 1)
+    {
+        func(0, count);
+
+        return;
+    }
+
+    auto job = std::make_shared<job_t>();
+    job->func = func;
+    job->count = count;
+    job->chunk_size = (count + num_chunks - 1) / num_chunks;
+    job->num_chunks = (count + job->chunk_size - 1) / job->chunk_size;
+    job->remaining.store(job->num_chunks);
+
+    {
+        std::lock_guard<std::mutex> lock(priv->mutex);
+        priv->current_job = job;
+        ++priv->generation;
+    }
+
+    priv->wake.notify_all();
+    job->run();
+
+    std::unique_lock<std::mutex> lock(job->done_mutex);
+    job->done.wait(lock, [&] { return job->remaining.load() == 0; });
+}
+
+wf::task_pool_t& wf::get_task_pool()
+{
+    static std::unique_ptr<task_pool_t> pool{new task_pool_t()};
+    return *pool;
+}
@@ -10,7 +10,6 @@
 
 #include "debug-func.hpp"
 #include "main.hpp"
-#include "wayfire/nonstd/safe-list.hpp"
 #include <wayfire/config/file.hpp>
 
 extern "C"
@@ -74,6 +73,15 @@ static void print_help()
         " -D,  --damage-debug      enable additional debug for damaged regions" <<
         std::endl;
     std::cout << " -R,  --damage-rerender   rerender damaged regions" << std::endl;
+    std::cout <<
+        " -B,  --no-batching       draw each damaged rectangle separately" <<
+        std::endl;
+    std::cout <<
+        " -I,  --input-debug       check input hit-testing against a full scan" <<
+        std::endl;
+    std::cout <<
+        " -P,  --profile-frames    log per-stage and per-hook frame timings" <<
+        std::endl;
     std::cout << " -v,  --version           print version and exit" << std::endl;
     exit(0);
 }
@@ -147,19 +155,6 @@ wlr_renderer *add_egl_depth_renderer(wlr_egl *egl, EGLenum platform,
     return renderer;
 }
 
-namespace wf
-{
-namespace _safe_list_detail
-{
-wl_event_loop *event_loop;
-void idle_cleanup_func(void *data)
-{
-    auto priv = reinterpret_cast<std::function<void()>*>(data);
-    (*priv)();
-}
-}
-}
-
 static bool drop_permissions(void)
 {
     if ((getuid() != geteuid()) || (getgid() != getegid()))
@@ -280,13 +275,16 @@ int main(int argc, char *argv[])
         {"debug", no_argument, NULL, 'd'},
         {"damage-debug", no_argument, NULL, 'D'},
         {"damage-rerender", no_argument, NULL, 'R'},
+        {"no-batching", no_argument, NULL, 'B'},
+        {"input-debug", no_argument, NULL, 'I'},
+        {"profile-frames", no_argument, NULL, 'P'},
         {"help", no_argument, NULL, 'h'},
         {"version", no_argument, NULL, 'v'},
         {0, 0, NULL, 0}
     };
 
     int c, i;
-    while ((c = getopt_long(argc, argv, "c:dDhRv", opts, &i)) != -1)
+    while ((c = getopt_long(argc, argv, "c:dDhRBIPv", opts, &i)) != -1)
     {
         switch (c)
         {
@@ -302,6 +300,18 @@ int main(int argc, char *argv[])
             runtime_config.no_damage_track = true;
             break;
 
+          case 'B':
+            runtime_config.no_batched_render = true;
+            break;
+
+          case 'I':
+            runtime_config.input_debug = true;
+            break;
+
+          case 'P':
+            runtime_config.profile_frames = true;
+            break;
+
           case 'h':
             print_help();
             break;
@@ -334,10 +344,7 @@ int main(int argc, char *argv[])
 #endif
 
     LOGI("Starting wayfire version ", WAYFIRE_VERSION);
-    /* First create display and initialize safe-list's event loop, so that
-     * wf objects (which depend on safe-list) can work */
     auto display = wl_display_create();
-    wf::_safe_list_detail::event_loop = wl_display_get_event_loop(display);
 
     auto& core = wf::get_core_impl();
 
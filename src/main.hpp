@@ -3,8 +3,11 @@
 
 extern struct wf_runtime_config
 {
-    bool no_damage_track = false;
-    bool damage_debug    = false;
+    bool no_damage_track   = false;
+    bool damage_debug      = false;
+    bool no_batched_render = false;
+    bool input_debug       = false;
+    bool profile_frames    = false;
 } runtime_config;
 
 #endif /* end of include guard: MAIN_HPP */
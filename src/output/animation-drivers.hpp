@@ -0,0 +1,64 @@
+#ifndef WF_OUTPUT_ANIMATION_DRIVERS_HPP
+#define WF_OUTPUT_ANIMATION_DRIVERS_HPP
+
+#include <functional>
+#include <wayfire/nonstd/safe-list.hpp>
+
+namespace wf
+{
+/**
+ * The animation drivers of an output, and the frame bookkeeping for them.
+ *
+ * The drivers are run once per frame. A frame is needed while some driver
+ * reports pending progress, and once more after all of them are done, so
+ * that the final state of the animations is shown.
+ */
+class animation_driver_list_t
+{
+  public:
+    /** Same as wf::animation_driver_t */
+    using driver_t = std::function<bool ()>;
+
+    void add(driver_t *driver)
+    {
+        drivers.push_back(driver);
+    }
+
+    void remove(driver_t *driver)
+    {
+        drivers.remove_all(driver);
+    }
+
+    /** Run all drivers at the start of a frame. */
+    void run()
+    {
+        animated_last_frame = animating;
+        animating = false;
+        drivers.for_each([&] (driver_t *driver)
+        {
+            animating |= (*driver)();
+        });
+    }
+
+    /** @return Whether the current frame has to be painted, even without
+     *   damage. */
+    bool needs_frame() const
+    {
+        return animating || animated_last_frame;
+    }
+
+    /** @return Whether another frame has to be scheduled after this one. */
+    bool needs_next_frame() const
+    {
+        return animating;
+    }
+
+  private:
+    wf::safe_list_t<driver_t*> drivers;
+    /* Whether a driver had pending progress in the current and in the
+     * previous frame */
+    bool animating = false, animated_last_frame = false;
+};
+}
+
+#endif /* end of include guard: WF_OUTPUT_ANIMATION_DRIVERS_HPP */
@@ -0,0 +1,495 @@
+#include "frame-profiler.hpp"
+#include <wayfire/opengl.hpp>
+#include <wayfire/util/log.hpp>
+#include <algorithm>
+#include <cstring>
+#include <cxxabi.h>
+#include <EGL/egl.h>
+#include <GLES2/gl2ext.h>
+
+void wf::frame_profile_ring_t::push(const frame_profile_t& profile)
+{
+    uint64_t index = written.load(std::memory_order_relaxed);
+    auto& slot     = slots[index % CAPACITY];
+
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.profile = profile;
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+
+    written.store(index + 1, std::memory_order_release);
+}
+
+uint64_t wf::frame_profile_ring_t::read_since(uint64_t since,
+    std::vector<frame_profile_t>& out) const
+{
+    uint64_t end = written.load(std::memory_order_acquire);
+    if (end - std::min(since, end) > CAPACITY)
+    {
+        since = end - CAPACITY;
+    }
+
+    for (uint64_t index = since; index < end; index++)
+    {
+        auto& slot = slots[index % CAPACITY];
+        uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        frame_profile_t profile = slot.profile;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+
+        if ((before == after) && (before == 2 * index + 2))
+        {
+            out.push_back(profile);
+        }
+    }
+
+    return end;
+}
+
+/* Entry points of GL_EXT_disjoint_timer_query */
+static PFNGLGENQUERIESEXTPROC gen_queries;
+static PFNGLDELETEQUERIESEXTPROC delete_queries;
+static PFNGLQUERYCOUNTEREXTPROC query_counter;
+static PFNGLGETQUERYOBJECTUIVEXTPROC get_query_uiv;
+static PFNGLGETQUERYOBJECTUI64VEXTPROC get_query_ui64v;
+
+/** Must be called with the GL context current */
+static bool load_timer_queries()
+{
+    static int supported = -1;
+    if (supported >= 0)
+    {
+        return supported;
+    }
+
+    auto extensions = (const char*)glGetString(GL_EXTENSIONS);
+    supported = extensions &&
+        std::strstr(extensions, "GL_EXT_disjoint_timer_query");
+    if (supported)
+    {
+        gen_queries = (PFNGLGENQUERIESEXTPROC)
+            eglGetProcAddress("glGenQueriesEXT");
+        delete_queries = (PFNGLDELETEQUERIESEXTPROC)
+            eglGetProcAddress("glDeleteQueriesEXT");
+        query_counter = (PFNGLQUERYCOUNTEREXTPROC)
+            eglGetProcAddress("glQueryCounterEXT");
+        get_query_uiv = (PFNGLGETQUERYOBJECTUIVEXTPROC)
+            eglGetProcAddress("glGetQueryObjectuivEXT");
+        get_query_ui64v = (PFNGLGETQUERYOBJECTUI64VEXTPROC)
+            eglGetProcAddress("glGetQueryObjectui64vEXT");
+
+        supported = gen_queries && delete_queries && query_counter &&
+            get_query_uiv && get_query_ui64v;
+    }
+
+    LOGI("Frame profiler: GPU timer queries are ",
+        supported ? "available" : "not available");
+
+    return supported;
+}
+
+static int64_t elapsed_ns(std::chrono::steady_clock::time_point since)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - since).count();
+}
+
+wf::frame_profiler_t::frame_profiler_t(std::string output_name)
+{
+    this->output_name = output_name;
+    this->last_dump   = std::chrono::steady_clock::now();
+}
+
+wf::frame_profiler_t::~frame_profiler_t()
+{
+    if (gpu_queries_created)
+    {
+        OpenGL::render_begin();
+        for (auto& frame : gpu_frames)
+        {
+            delete_queries(frame.queries.size(), frame.queries.data());
+        }
+
+        OpenGL::render_end();
+    }
+}
+
+void wf::frame_profiler_t::begin_frame()
+{
+    in_frame   = true;
+    gpu_active = false;
+    open_sections.clear();
+
+    current.frame  = frame_counter++;
+    current.cpu_ns = 0;
+    current.gpu_ns = -1;
+    current.num_sections = 0;
+    frame_start = std::chrono::steady_clock::now();
+}
+
+void wf::frame_profiler_t::begin_gpu_frame()
+{
+    if (!in_frame || !load_timer_queries())
+    {
+        return;
+    }
+
+    if (!gpu_queries_created)
+    {
+        for (auto& frame : gpu_frames)
+        {
+            gen_queries(frame.queries.size(), frame.queries.data());
+        }
+
+        gpu_queries_created = true;
+    }
+
+    collect_gpu_frames(false);
+    if (gpu_frames[current.frame % FRAMES_IN_FLIGHT].pending)
+    {
+        /* The GPU is more than FRAMES_IN_FLIGHT frames behind */
+        collect_gpu_frames(true);
+    }
+
+    gpu_active = true;
+}
+
+void wf::frame_profiler_t::discard_frame()
+{
+    in_frame = false;
+}
+
+void wf::frame_profiler_t::end_frame()
+{
+    if (!in_frame)
+    {
+        return;
+    }
+
+    in_frame = false;
+    current.cpu_ns = elapsed_ns(frame_start);
+
+    if (gpu_active)
+    {
+        auto& frame = gpu_frames[current.frame % FRAMES_IN_FLIGHT];
+        frame.profile = current;
+        frame.pending = true;
+    } else
+    {
+        store(current);
+    }
+
+    if (std::chrono::steady_clock::now() - last_dump >= DUMP_INTERVAL)
+    {
+        dump();
+    }
+}
+
+void wf::frame_profiler_t::begin_section(const char *name, bool gpu)
+{
+    if (!in_frame)
+    {
+        return;
+    }
+
+    auto it = stage_names.find(name);
+    if (it == stage_names.end())
+    {
+        it = stage_names.emplace(name, name).first;
+    }
+
+    begin_section(&it->second, gpu);
+}
+
+void wf::frame_profiler_t::begin_section(const std::type_info& hook, bool gpu)
+{
+    if (!in_frame)
+    {
+        return;
+    }
+
+    auto it = hook_names.find(hook);
+    if (it == hook_names.end())
+    {
+        int status;
+        char *demangled =
+            abi::__cxa_demangle(hook.name(), nullptr, nullptr, &status);
+        std::string name = (status == 0) ? demangled : hook.name();
+        free(demangled);
+
+        /* Lambdas are named after the class or function they are defined in */
+        auto lambda = name.find("::{lambda");
+        if (lambda != std::string::npos)
+        {
+            name = name.substr(0, lambda);
+        }
+
+        it = hook_names.emplace(hook, name).first;
+    }
+
+    begin_section(&it->second, gpu);
+}
+
+void wf::frame_profiler_t::begin_section(const std::string *name, bool gpu)
+{
+    if (current.num_sections >= frame_profile_t::MAX_SECTIONS)
+    {
+        open_sections.push_back(-1);
+
+        return;
+    }
+
+    int idx = current.num_sections++;
+    auto& section = current.sections[idx];
+    section.name   = name;
+    section.depth  = open_sections.size();
+    section.cpu_ns = 0;
+    section.gpu_ns = -1;
+
+    if (gpu && gpu_active)
+    {
+        auto& frame = gpu_frames[current.frame % FRAMES_IN_FLIGHT];
+        query_counter(frame.queries[2 * idx], GL_TIMESTAMP_EXT);
+        section.gpu_ns = 0;
+    }
+
+    open_sections.push_back(idx);
+    section_start[idx] = std::chrono::steady_clock::now();
+}
+
+void wf::frame_profiler_t::end_section()
+{
+    if (!in_frame || open_sections.empty())
+    {
+        return;
+    }
+
+    int idx = open_sections.back();
+    open_sections.pop_back();
+    if (idx < 0)
+    {
+        return;
+    }
+
+    auto& section = current.sections[idx];
+    section.cpu_ns = elapsed_ns(section_start[idx]);
+    if (section.gpu_ns >= 0)
+    {
+        auto& frame = gpu_frames[current.frame % FRAMES_IN_FLIGHT];
+        query_counter(frame.queries[2 * idx + 1], GL_TIMESTAMP_EXT);
+    }
+}
+
+void wf::frame_profiler_t::collect_gpu_frames(bool force)
+{
+    /* Store the frames in the order they were rendered */
+    std::array<gpu_frame_t*, FRAMES_IN_FLIGHT> pending;
+    int num_pending = 0;
+    for (auto& frame : gpu_frames)
+    {
+        if (frame.pending)
+        {
+            pending[num_pending++] = &frame;
+        }
+    }
+
+    std::sort(pending.begin(), pending.begin() + num_pending,
+        [] (gpu_frame_t *a, gpu_frame_t *b)
+    {
+        return a->profile.frame < b->profile.frame;
+    });
+
+    /* Reading GL_GPU_DISJOINT_EXT also resets it, so remember it until all
+     * frames which were running at the time have been stored */
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    gpu_disjoint |= disjoint;
+
+    for (int i = 0; i < num_pending; i++)
+    {
+        auto& frame   = *pending[i];
+        auto& profile = frame.profile;
+
+        /* Queries finish in order, so check only the last one */
+        int last = -1;
+        for (int s = 0; s < profile.num_sections; s++)
+        {
+            if (profile.sections[s].gpu_ns >= 0)
+            {
+                last = s;
+            }
+        }
+
+        GLuint available = 1;
+        if (last >= 0)
+        {
+            get_query_uiv(frame.queries[2 * last + 1],
+                GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+        }
+
+        if (!available && !force)
+        {
+            /* Later frames cannot have finished either */
+            break;
+        }
+
+        for (int s = 0; s < profile.num_sections; s++)
+        {
+            auto& section = profile.sections[s];
+            if (section.gpu_ns < 0)
+            {
+                continue;
+            }
+
+            if (!available || gpu_disjoint)
+            {
+                section.gpu_ns = -1;
+                continue;
+            }
+
+            GLuint64 begin, end;
+            get_query_ui64v(frame.queries[2 * s], GL_QUERY_RESULT_EXT, &begin);
+            get_query_ui64v(frame.queries[2 * s + 1], GL_QUERY_RESULT_EXT, &end);
+            section.gpu_ns = end - begin;
+
+            if (section.depth == 0)
+            {
+                profile.gpu_ns = std::max<int64_t>(profile.gpu_ns, 0) +
+                    section.gpu_ns;
+            }
+        }
+
+        frame.pending = false;
+        store(profile);
+    }
+
+    gpu_disjoint &= std::any_of(gpu_frames.begin(), gpu_frames.end(),
+        [] (const gpu_frame_t& frame) { return frame.pending; });
+}
+
+void wf::frame_profiler_t::store(frame_profile_t& profile)
+{
+    profiles.push(profile);
+}
+
+const wf::frame_profile_ring_t& wf::frame_profiler_t::get_profiles() const
+{
+    return profiles;
+}
+
+namespace
+{
+struct section_stats_t
+{
+    const std::string *name;
+    /** The stage a hook was run in */
+    const std::string *stage;
+    int depth;
+    int64_t count = 0;
+    int64_t cpu_total = 0, cpu_max = 0;
+    int64_t gpu_count = 0;
+    int64_t gpu_total = 0, gpu_max = 0;
+
+    void add(int64_t cpu, int64_t gpu)
+    {
+        ++count;
+        cpu_total += cpu;
+        cpu_max    = std::max(cpu_max, cpu);
+        if (gpu >= 0)
+        {
+            ++gpu_count;
+            gpu_total += gpu;
+            gpu_max    = std::max(gpu_max, gpu);
+        }
+    }
+
+    std::string format() const
+    {
+        char buffer[128];
+        int len = snprintf(buffer, sizeof(buffer),
+            "cpu avg %.2f ms, max %.2f ms", cpu_total / 1e6 / count,
+            cpu_max / 1e6);
+        if (gpu_count)
+        {
+            snprintf(buffer + len, sizeof(buffer) - len,
+                "; gpu avg %.2f ms, max %.2f ms", gpu_total / 1e6 / gpu_count,
+                gpu_max / 1e6);
+        }
+
+        return buffer;
+    }
+};
+}
+
+void wf::frame_profiler_t::dump()
+{
+    last_dump = std::chrono::steady_clock::now();
+
+    std::vector<frame_profile_t> frames;
+    last_dumped = profiles.read_since(last_dumped, frames);
+    if (frames.empty())
+    {
+        return;
+    }
+
+    section_stats_t total;
+    /* Sections in order of first appearance, stages followed by their hooks */
+    std::vector<section_stats_t> sections;
+    for (auto& frame : frames)
+    {
+        total.add(frame.cpu_ns, frame.gpu_ns);
+
+        size_t stage = 0;
+        const std::string *stage_name = nullptr;
+        for (int s = 0; s < frame.num_sections; s++)
+        {
+            auto& section = frame.sections[s];
+            if (section.depth == 0)
+            {
+                stage_name = section.name;
+            }
+
+            auto it = std::find_if(sections.begin(), sections.end(),
+                [&] (const section_stats_t& stats)
+            {
+                return stats.name == section.name &&
+                stats.stage == stage_name && stats.depth == section.depth;
+            });
+
+            if (it == sections.end())
+            {
+                /* Insert hooks after the stage they were run in */
+                size_t pos = sections.size();
+                if (section.depth > 0)
+                {
+                    pos = stage + 1;
+                    while (pos < sections.size() && sections[pos].depth > 0)
+                    {
+                        ++pos;
+                    }
+                }
+
+                section_stats_t stats;
+                stats.name  = section.name;
+                stats.stage = stage_name;
+                stats.depth = section.depth;
+                it = sections.insert(sections.begin() + pos, stats);
+            }
+
+            if (section.depth == 0)
+            {
+                stage = it - sections.begin();
+            }
+
+            it->add(section.cpu_ns, section.gpu_ns);
+        }
+    }
+
+    LOGI("Frame profile of output ", output_name, ", ", frames.size(),
+        " frames: ", total.format());
+    for (auto& stats : sections)
+    {
+        LOGI(std::string(2 + 2 * stats.depth, ' '), *stats.name, " (",
+            stats.count, "x): ", stats.format());
+    }
+}
@@ -0,0 +1,170 @@
+#ifndef WF_OUTPUT_FRAME_PROFILER_HPP
+#define WF_OUTPUT_FRAME_PROFILER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+#include <GLES3/gl3.h>
+
+namespace wf
+{
+/** The timings of one stage of a frame, or of a plugin hook inside a stage. */
+struct frame_profile_section_t
+{
+    /** The name of the stage or hook, owned by the profiler */
+    const std::string *name;
+    /** 0 for stages, 1 for the hooks run by a stage */
+    int depth;
+    int64_t cpu_ns;
+    /** -1 if the GPU time was not measured */
+    int64_t gpu_ns;
+};
+
+struct frame_profile_t
+{
+    static constexpr int MAX_SECTIONS = 64;
+
+    uint64_t frame;
+    int64_t cpu_ns;
+    /** The sum of the GPU times of all stages, -1 if not measured */
+    int64_t gpu_ns;
+
+    int num_sections;
+    std::array<frame_profile_section_t, MAX_SECTIONS> sections;
+};
+
+/**
+ * A fixed-size ring buffer of frame profiles.
+ *
+ * There is a single writer, which is never blocked by readers. Each slot
+ * carries a sequence number, so that readers can detect and skip slots which
+ * were overwritten while they were being copied.
+ */
+class frame_profile_ring_t
+{
+  public:
+    static constexpr uint64_t CAPACITY = 256;
+
+    void push(const frame_profile_t& profile);
+
+    /**
+     * Append the profiles with index >= since to out, oldest first. Profiles
+     * which were already overwritten are skipped.
+     *
+     * @return The total number of profiles written so far.
+     */
+    uint64_t read_since(uint64_t since, std::vector<frame_profile_t>& out) const;
+
+  private:
+    struct slot_t
+    {
+        /* 2 * index + 1 while writing, 2 * index + 2 once written */
+        std::atomic<uint64_t> sequence{0};
+        frame_profile_t profile;
+    };
+
+    std::array<slot_t, CAPACITY> slots;
+    std::atomic<uint64_t> written{0};
+};
+
+/**
+ * Records the CPU and GPU time of the stages of each frame on an output, and
+ * of the plugin hooks run in them. CPU times are measured with a monotonic
+ * clock, GPU times with GL_EXT_disjoint_timer_query, if available. GPU times
+ * become available a few frames later, so a frame is stored in the ring
+ * buffer once its queries have finished.
+ *
+ * A summary of the last frames is logged every few seconds.
+ */
+class frame_profiler_t
+{
+  public:
+    frame_profiler_t(std::string output_name);
+    ~frame_profiler_t();
+
+    /** Start recording a new frame. */
+    void begin_frame();
+
+    /**
+     * The GL context is current and the frame will be rendered, so GPU timed
+     * sections can be recorded from now on.
+     */
+    void begin_gpu_frame();
+
+    /** The frame is not going to be rendered, drop it. */
+    void discard_frame();
+
+    /** Finish the frame. */
+    void end_frame();
+
+    /**
+     * Start a section nested in the current one.
+     *
+     * @param name The name of the section. Must be a string literal.
+     * @param gpu Whether to also measure GPU time. Only possible after
+     *   begin_gpu_frame().
+     */
+    void begin_section(const char *name, bool gpu);
+
+    /**
+     * Start a section for a plugin hook. The section is named after the type
+     * of the hook, i.e. after the class of the plugin in most cases.
+     */
+    void begin_section(const std::type_info& hook, bool gpu);
+    void end_section();
+
+    const frame_profile_ring_t& get_profiles() const;
+
+  private:
+    static constexpr int FRAMES_IN_FLIGHT = 4;
+    static constexpr std::chrono::seconds DUMP_INTERVAL{5};
+
+    std::string output_name;
+    frame_profile_ring_t profiles;
+
+    std::unordered_map<const char*, std::string> stage_names;
+    std::unordered_map<std::type_index, std::string> hook_names;
+
+    bool in_frame = false;
+    uint64_t frame_counter = 0;
+    frame_profile_t current;
+    std::chrono::steady_clock::time_point frame_start;
+    std::array<std::chrono::steady_clock::time_point,
+        frame_profile_t::MAX_SECTIONS> section_start;
+    /* Indices of the open sections, -1 for sections which did not fit */
+    std::vector<int> open_sections;
+
+    /** Frames waiting for the results of their timer queries */
+    struct gpu_frame_t
+    {
+        std::array<GLuint, 2 * frame_profile_t::MAX_SECTIONS> queries;
+        bool pending = false;
+        frame_profile_t profile;
+    };
+
+    bool gpu_queries_created = false;
+    bool gpu_active = false;
+    bool gpu_disjoint = false;
+    std::array<gpu_frame_t, FRAMES_IN_FLIGHT> gpu_frames;
+
+    /**
+     * Store the pending GPU frames whose queries have finished. If force is
+     * set, frames which are still running are stored without GPU times.
+     */
+    void collect_gpu_frames(bool force);
+    void store(frame_profile_t& profile);
+
+    uint64_t last_dumped = 0;
+    std::chrono::steady_clock::time_point last_dump;
+    void dump();
+
+    void begin_section(const std::string *name, bool gpu);
+};
+}
+
+#endif /* end of include guard: WF_OUTPUT_FRAME_PROFILER_HPP */
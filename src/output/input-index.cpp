@@ -0,0 +1,116 @@
+#include "input-index.hpp"
+#include "../view/subsurface.hpp"
+#include <wayfire/output.hpp>
+#include <wayfire/workspace-manager.hpp>
+#include <cmath>
+
+/* Size of a grid cell in output-local pixels */
+static constexpr int CELL_SIZE = 128;
+
+/**
+ * Client subsurfaces can be moved or resized with a plain commit, which does
+ * not emit a geometry signal on the view.
+ */
+static bool has_client_subsurfaces(wayfire_view view)
+{
+    for (auto& child : view->enumerate_surfaces())
+    {
+        if (dynamic_cast<wf::subsurface_implementation_t*>(child.surface))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+wf::input_index_t::input_index_t(wf::output_t *output)
+{
+    this->output = output;
+
+    on_view_changed = [=] (wf::signal_data_t*) { invalidate(); };
+    for (auto signal : {"view-geometry-changed", "view-mapped",
+        "view-disappeared", "view-minimized", "stack-order-changed",
+        "view-layer-detached", "workspace-changed",
+        "output-configuration-changed"})
+    {
+        output->connect_signal(signal, &on_view_changed);
+    }
+}
+
+wf::input_index_t::~input_index_t() = default;
+
+void wf::input_index_t::invalidate()
+{
+    dirty = true;
+}
+
+int wf::input_index_t::get_cell(wf::pointf_t point) const
+{
+    if (std::isnan(point.x) || std::isnan(point.y) ||
+        (point.x < 0) || (point.y < 0))
+    {
+        return -1;
+    }
+
+    int column = std::min((int)point.x / CELL_SIZE, columns - 1);
+    int row    = std::min((int)point.y / CELL_SIZE, rows - 1);
+    if ((column < 0) || (row < 0))
+    {
+        return -1;
+    }
+
+    return row * columns + column;
+}
+
+void wf::input_index_t::rebuild()
+{
+    dirty = false;
+
+    auto og = output->get_relative_geometry();
+    columns = (og.width + CELL_SIZE - 1) / CELL_SIZE;
+    rows    = (og.height + CELL_SIZE - 1) / CELL_SIZE;
+
+    /* Clear but keep the allocated memory, so that steady-state rebuilds do
+     * not need to allocate */
+    entries.clear();
+    cells.resize(std::max(columns * rows, 0));
+    for (auto& cell : cells)
+    {
+        cell.clear();
+    }
+
+    auto add_view = [&] (wayfire_view view)
+    {
+        /* The bounding box of transformed views and of views with
+         * subsurfaces may change at any time */
+        bool unstable = view->has_transformer() ||
+            has_client_subsurfaces(view);
+        auto box = unstable ? og :
+            wf::geometry_intersection(view->get_bounding_box(), og);
+        if ((box.width > 0) && (box.height > 0))
+        {
+            entries.push_back({view, box});
+        }
+    };
+
+    output->workspace->for_each_view_in_layer(wf::VISIBLE_LAYERS,
+        [&] (wayfire_view v) { v->for_each_view(add_view); });
+
+    for (uint32_t i = 0; i < entries.size(); i++)
+    {
+        const auto& box = entries[i].box;
+        int x1 = box.x / CELL_SIZE;
+        int y1 = box.y / CELL_SIZE;
+        int x2 = std::min((box.x + box.width - 1) / CELL_SIZE, columns - 1);
+        int y2 = std::min((box.y + box.height - 1) / CELL_SIZE, rows - 1);
+
+        for (int row = y1; row <= y2; row++)
+        {
+            for (int column = x1; column <= x2; column++)
+            {
+                cells[row * columns + column].push_back(i);
+            }
+        }
+    }
+}
@@ -0,0 +1,101 @@
+#ifndef WF_OUTPUT_INPUT_INDEX_HPP
+#define WF_OUTPUT_INPUT_INDEX_HPP
+
+#include <vector>
+#include <cstdint>
+#include <wayfire/view.hpp>
+#include <wayfire/object.hpp>
+
+namespace wf
+{
+/**
+ * A spatial index of the input-receiving views on an output, used to find the
+ * surface under the cursor without scanning every view on each input event.
+ *
+ * The output is split into a uniform grid. Each grid cell stores the views
+ * whose bounding box intersects the cell, in stacking order. Hit-testing thus
+ * only looks at the views which may contain the point.
+ *
+ * The index is rebuilt lazily on the first query after it has been
+ * invalidated. It is invalidated when the geometry of a view changes, when a
+ * view is mapped, unmapped or minimized, when a transformer is added or
+ * removed, when the stacking order changes, when the workspace changes and
+ * when the output mode, scale or transform changes. Damage from surface
+ * commits does not invalidate it.
+ *
+ * Transformers may change the bounding box of a view on every frame without
+ * notice, and client subsurfaces may be moved or resized by a plain commit.
+ * Views with transformers or subsurfaces are therefore put in every cell and
+ * rely on the exact test done by the caller.
+ *
+ * A query costs O(k), where k is the number of views in the cell under the
+ * point. In the worst case, when every view overlaps that cell (for ex. many
+ * maximized or transformed views), this is the same as a linear scan over
+ * all views. A rebuild costs O(n + c), where c is the total number of cells
+ * covered by all views.
+ */
+class input_index_t : public noncopyable_t
+{
+  public:
+    input_index_t(wf::output_t *output);
+    ~input_index_t();
+
+    /** Mark the index as outdated. */
+    void invalidate();
+
+    /**
+     * Call @callback for each view whose bounding box contains @point, from
+     * top to bottom, until the callback returns true.
+     *
+     * @param point The point to test, in output-local coordinates.
+     */
+    template<class Callback>
+    void for_each_view_at(wf::pointf_t point, Callback callback)
+    {
+        if (dirty)
+        {
+            rebuild();
+        }
+
+        int cell = get_cell(point);
+        if (cell < 0)
+        {
+            return;
+        }
+
+        for (auto idx : cells[cell])
+        {
+            auto& entry = entries[idx];
+            if ((entry.box & point) && callback(entry.view))
+            {
+                return;
+            }
+        }
+    }
+
+  private:
+    wf::output_t *output;
+    bool dirty = true;
+
+    struct entry_t
+    {
+        wayfire_view view;
+        /* Bounding box, clipped to the output */
+        wf::geometry_t box;
+    };
+
+    /* All indexed views, from top to bottom */
+    std::vector<entry_t> entries;
+    /* Indices into entries for each grid cell, from top to bottom */
+    std::vector<std::vector<uint32_t>> cells;
+    int columns = 0, rows = 0;
+
+    wf::signal_connection_t on_view_changed;
+
+    /** @return The index of the cell containing the point, or -1 if outside */
+    int get_cell(wf::pointf_t point) const;
+    void rebuild();
+};
+}
+
+#endif /* end of include guard: WF_OUTPUT_INPUT_INDEX_HPP */
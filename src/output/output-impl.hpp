@@ -1,5 +1,6 @@
 #include "wayfire/output.hpp"
 #include "plugin-loader.hpp"
+#include "input-index.hpp"
 
 #include <unordered_set>
 #include <wayfire/nonstd/safe-list.hpp>
@@ -88,5 +89,8 @@ class output_impl_t : public output_t
 
     /** Set the effective resolution of the output */
     void set_effective_size(const wf::dimensions_t& size);
+
+    /** Spatial index of the views on the output, used for hit-testing */
+    std::unique_ptr<input_index_t> input_index;
 };
 }
@@ -29,6 +29,7 @@ wf::output_impl_t::output_impl_t(wlr_output *handle,
     this->handle = handle;
     workspace    = std::make_unique<workspace_manager>(this);
     render = std::make_unique<render_manager>(this);
+    input_index = std::make_unique<input_index_t>(this);
 
     view_disappeared_cb = [=] (wf::signal_data_t *data)
     {
@@ -26,6 +26,16 @@ B union_cast(A object)
 
     return helper.y;
 }
+
+struct global_plugin_entry_t
+{
+    wayfire_plugin plugin;
+    /* Number of outputs the plugin is enabled on */
+    int ref_count = 0;
+};
+
+/* Instances of the global plugins, shared by all outputs, by path */
+std::unordered_map<std::string, global_plugin_entry_t> global_plugins;
 }
 
 plugin_manager::plugin_manager(wf::output_t *o)
@@ -57,6 +67,20 @@ void plugin_manager::deinit_plugins(bool unloadable)
             destroy_plugin(p.second);
         }
     }
+
+    auto it = enabled_global_plugins.begin();
+    while (it != enabled_global_plugins.end())
+    {
+        if (global_plugins[*it].plugin->is_unloadable() == unloadable)
+        {
+            auto path = *it;
+            it = enabled_global_plugins.erase(it);
+            remove_global_plugin_output(path);
+        } else
+        {
+            ++it;
+        }
+    }
 }
 
 plugin_manager::~plugin_manager()
@@ -79,8 +103,12 @@ void plugin_manager::destroy_plugin(wayfire_plugin& p)
 {
     p->fini();
 
-    p->grab_interface->ungrab();
-    output->deactivate_plugin(p->grab_interface);
+    /* Global plugins have no grab interface */
+    if (p->grab_interface)
+    {
+        p->grab_interface->ungrab();
+        output->deactivate_plugin(p->grab_interface);
+    }
 
     auto handle = p->handle;
     p.reset();
@@ -96,6 +124,28 @@ void plugin_manager::destroy_plugin(wayfire_plugin& p)
     }
 }
 
+void plugin_manager::add_global_plugin_output(const std::string& path)
+{
+    auto& entry = global_plugins[path];
+    ++entry.ref_count;
+    entry.plugin->handle_output_added(output);
+}
+
+void plugin_manager::remove_global_plugin_output(const std::string& path)
+{
+    auto it = global_plugins.find(path);
+    it->second.plugin->handle_output_removed(output);
+    if (--it->second.ref_count > 0)
+    {
+        return;
+    }
+
+    LOGD("destroy global plugin ", path.c_str());
+    auto plugin = std::move(it->second.plugin);
+    global_plugins.erase(it);
+    destroy_plugin(plugin);
+}
+
 wayfire_plugin plugin_manager::load_plugin_from_file(std::string path)
 {
     // RTLD_GLOBAL is required for RTTI/dynamic_cast across plugins
@@ -222,16 +272,52 @@ void plugin_manager::reload_dynamic_plugins()
         }
     }
 
+    auto global_it = enabled_global_plugins.begin();
+    while (global_it != enabled_global_plugins.end())
+    {
+        if ((std::find(next_plugins.begin(), next_plugins.end(),
+            *global_it) == next_plugins.end()) &&
+            global_plugins[*global_it].plugin->is_unloadable())
+        {
+            LOGD("unload global plugin ", global_it->c_str());
+            auto path = *global_it;
+            global_it = enabled_global_plugins.erase(global_it);
+            remove_global_plugin_output(path);
+        } else
+        {
+            ++global_it;
+        }
+    }
+
     /* load new plugins */
     for (auto plugin : next_plugins)
     {
-        if (loaded_plugins.count(plugin))
+        if (loaded_plugins.count(plugin) || enabled_global_plugins.count(plugin))
         {
             continue;
         }
 
+        /* Already loaded for another output */
+        if (global_plugins.count(plugin))
+        {
+            enabled_global_plugins.insert(plugin);
+            add_global_plugin_output(plugin);
+            continue;
+        }
+
         auto ptr = load_plugin_from_file(plugin);
-        if (ptr)
+        if (!ptr)
+        {
+            continue;
+        }
+
+        if (ptr->is_global())
+        {
+            ptr->init();
+            global_plugins[plugin].plugin = std::move(ptr);
+            enabled_global_plugins.insert(plugin);
+            add_global_plugin_output(plugin);
+        } else
         {
             init_plugin(ptr);
             loaded_plugins[plugin] = std::move(ptr);
@@ -1,6 +1,7 @@
 #ifndef PLUGIN_LOADER_HPP
 #define PLUGIN_LOADER_HPP
 
+#include <set>
 #include <vector>
 #include <unordered_map>
 #include "wayfire/plugin.hpp"
@@ -28,6 +29,8 @@ struct plugin_manager
     wf::output_t *output;
     wf::option_wrapper_t<std::string> plugins_opt;
     std::unordered_map<std::string, wayfire_plugin> loaded_plugins;
+    /* Paths of the global plugins enabled on this output */
+    std::set<std::string> enabled_global_plugins;
 
     void deinit_plugins(bool unloadable);
 
@@ -36,6 +39,12 @@ struct plugin_manager
 
     void init_plugin(wayfire_plugin& plugin);
     void destroy_plugin(wayfire_plugin& plugin);
+
+    /* Add this output to an already initialized global plugin */
+    void add_global_plugin_output(const std::string& path);
+    /* Remove this output from a global plugin, and destroy the plugin if this
+     * was the last output using it */
+    void remove_global_plugin_output(const std::string& path);
 };
 
 #endif /* end of include guard: PLUGIN_LOADER_HPP */
@@ -4,10 +4,16 @@
 #include "../core/core-impl.hpp"
 #include "wayfire/util.hpp"
 #include "wayfire/workspace-manager.hpp"
+#include "wayfire/signal-definitions.hpp"
 #include "../core/seat/input-manager.hpp"
 #include "../core/opengl-priv.hpp"
+#include "workspace-stream-cache.hpp"
+#include "frame-profiler.hpp"
+#include "animation-drivers.hpp"
 #include "../main.hpp"
 #include <algorithm>
+#include <cmath>
+#include <unordered_map>
 #include <wayfire/nonstd/reverse.hpp>
 #include <wayfire/nonstd/safe-list.hpp>
 #include <wayfire/util/log.hpp>
@@ -48,6 +54,102 @@ struct output_damage_t
         on_damage_destroy.connect(&damage_manager->events.destroy);
     }
 
+    /**
+     * Damage of a single workspace, in workspace-local logical coordinates.
+     */
+    struct ws_damage_t
+    {
+        wf::region_t region;
+        /* The whole workspace is damaged, region is not relevant */
+        bool whole = false;
+    };
+
+    /* Damage for each workspace in the grid, row by row */
+    std::vector<ws_damage_t> ws_damage;
+    wf::dimensions_t ws_grid = {0, 0};
+    /* Whether any workspace has damage which needs to be cleared */
+    bool has_ws_damage = false;
+
+    /**
+     * Make sure ws_damage matches the workspace grid. Newly tracked workspaces
+     * are fully damaged.
+     *
+     * @return false if the workspace grid is not available yet.
+     */
+    bool ensure_ws_damage()
+    {
+        if (!wo->workspace)
+        {
+            return false;
+        }
+
+        auto grid = wo->workspace->get_workspace_grid_size();
+        if ((grid.width != ws_grid.width) || (grid.height != ws_grid.height))
+        {
+            ws_grid = grid;
+            ws_damage.clear();
+            ws_damage.resize(std::max(grid.width * grid.height, 0));
+            for (auto& ws : ws_damage)
+            {
+                ws.whole = true;
+            }
+
+            has_ws_damage = true;
+        }
+
+        return true;
+    }
+
+    /**
+     * Add the given output-local region to the damage of each workspace it
+     * touches. Only the workspaces overlapping the region extents are visited.
+     */
+    void damage_workspaces(const wf::region_t& region)
+    {
+        if (!ensure_ws_damage())
+        {
+            return;
+        }
+
+        auto size = wo->get_screen_size();
+        if ((size.width <= 0) || (size.height <= 0))
+        {
+            return;
+        }
+
+        /* Floor division, so that negative coordinates map to workspaces
+         * left/above the current one */
+        auto ws_index = [] (int coord, int size)
+        {
+            return (coord >= 0) ? coord / size : -((size - 1 - coord) / size);
+        };
+
+        auto vp  = wo->workspace->get_current_workspace();
+        auto ext = region.get_extents();
+        int x1   = std::max(vp.x + ws_index(ext.x1, size.width), 0);
+        int y1   = std::max(vp.y + ws_index(ext.y1, size.height), 0);
+        int x2   = std::min(vp.x + ws_index(ext.x2 - 1, size.width),
+            ws_grid.width - 1);
+        int y2 = std::min(vp.y + ws_index(ext.y2 - 1, size.height),
+            ws_grid.height - 1);
+
+        for (int y = y1; y <= y2; y++)
+        {
+            for (int x = x1; x <= x2; x++)
+            {
+                auto& ws = ws_damage[y * ws_grid.width + x];
+                if (ws.whole)
+                {
+                    continue;
+                }
+
+                auto box = get_ws_box({x, y});
+                ws.region |= (region & box) + wf::point_t{-box.x, -box.y};
+                has_ws_damage = true;
+            }
+        }
+    }
+
     /**
      * Damage the given region
      */
@@ -60,8 +162,9 @@ struct output_damage_t
 
         /* Wlroots expects damage after scaling */
         auto scaled_region = region * wo->handle->scale;
-        frame_damage |= scaled_region;
+        frame_damage |= scaled_region & get_wlr_damage_box();
         wlr_output_damage_add(damage_manager, scaled_region.to_pixman());
+        damage_workspaces(region);
     }
 
     void damage(const wf::geometry_t& box)
@@ -73,8 +176,10 @@ struct output_damage_t
 
         /* Wlroots expects damage after scaling */
         auto scaled_box = box * wo->handle->scale;
-        frame_damage |= scaled_box;
+        frame_damage |= wf::geometry_intersection(scaled_box,
+            get_wlr_damage_box());
         wlr_output_damage_add_box(damage_manager, &scaled_box);
+        damage_workspaces(box);
     }
 
     /**
@@ -112,7 +217,9 @@ struct output_damage_t
 
     /**
      * Return the damage that has been scheduled for the next frame up to now,
-     * or, if in a repaint, the damage for the current frame
+     * or, if in a repaint, the damage for the current frame. Only the visible
+     * part of the output is tracked here, damage on other workspaces is kept
+     * in ws_damage.
      */
     wf::region_t get_scheduled_damage()
     {
@@ -147,6 +254,17 @@ struct output_damage_t
             const_cast<wf::region_t&>(swap_damage).to_pixman());
         wlr_output_commit(output);
         frame_damage.clear();
+
+        if (has_ws_damage)
+        {
+            for (auto& ws : ws_damage)
+            {
+                ws.region.clear();
+                ws.whole = false;
+            }
+
+            has_ws_damage = false;
+        }
     }
 
     bool force_next_frame = false;
@@ -191,26 +309,63 @@ struct output_damage_t
      */
     wf::region_t get_ws_damage(wf::point_t ws)
     {
-        auto scaled = frame_damage * (1.0 / wo->handle->scale);
+        auto box = get_ws_box(ws);
+        if (!damage_manager || !ensure_ws_damage())
+        {
+            return {};
+        }
+
+        wf::region_t result;
+        if ((ws.x >= 0) && (ws.x < ws_grid.width) &&
+            (ws.y >= 0) && (ws.y < ws_grid.height))
+        {
+            auto& damage = ws_damage[ws.y * ws_grid.width + ws.x];
+            if (damage.whole)
+            {
+                return box;
+            }
+
+            if (!damage.region.empty())
+            {
+                result = damage.region + wf::point_t{box.x, box.y};
+            }
+        }
+
+        /* The visible workspace also needs to repaint the damage wlroots
+         * accumulated for the buffer we are rendering to */
+        if (ws == wo->workspace->get_current_workspace())
+        {
+            result |= get_scheduled_damage() & box;
+        }
 
-        return scaled & get_ws_box(ws);
+        return result;
     }
 
     /**
      * Same as render_manager::damage_whole()
+     *
+     * This only flags the workspaces as damaged, so it does not depend on the
+     * size of the workspace grid beyond one flag per workspace.
      */
     void damage_whole()
     {
-        auto vsize = wo->workspace->get_workspace_grid_size();
-        auto vp    = wo->workspace->get_current_workspace();
-        auto res   = wo->get_screen_size();
+        if (!damage_manager)
+        {
+            return;
+        }
 
-        damage(wf::geometry_t{
-                -vp.x * res.width,
-                -vp.y * res.height,
-                vsize.width * res.width,
-                vsize.height * res.height,
-            });
+        frame_damage |= get_wlr_damage_box();
+        wlr_output_damage_add_whole(damage_manager);
+
+        if (ensure_ws_damage())
+        {
+            for (auto& ws : ws_damage)
+            {
+                ws.whole = true;
+            }
+
+            has_ws_damage = true;
+        }
     }
 
     wf::wl_idle_call idle_damage;
@@ -227,6 +382,33 @@ struct output_damage_t
     }
 };
 
+/** Start a stage of the frame in the profiler, if profiling */
+static void begin_stage(frame_profiler_t *profiler, const char *name, bool gpu)
+{
+    if (profiler)
+    {
+        profiler->begin_section(name, gpu);
+    }
+}
+
+/** Start a section for a plugin hook in the profiler, if profiling */
+static void begin_stage(frame_profiler_t *profiler, const std::type_info& hook,
+    bool gpu)
+{
+    if (profiler)
+    {
+        profiler->begin_section(hook, gpu);
+    }
+}
+
+static void end_stage(frame_profiler_t *profiler)
+{
+    if (profiler)
+    {
+        profiler->end_section();
+    }
+}
+
 /**
  * Very simple class to manage effect hooks
  */
@@ -234,6 +416,7 @@ struct effect_hook_manager_t
 {
     using effect_container_t = wf::safe_list_t<effect_hook_t*>;
     effect_container_t effects[OUTPUT_EFFECT_TOTAL];
+    frame_profiler_t *profiler = nullptr;
 
     void add_effect(effect_hook_t *hook, output_effect_type_t type)
     {
@@ -250,8 +433,19 @@ struct effect_hook_manager_t
 
     void run_effects(output_effect_type_t type)
     {
-        effects[type].for_each([] (auto effect)
-        { (*effect)(); });
+        static const char *names[OUTPUT_EFFECT_TOTAL] = {
+            "pre", "damage", "overlay", "post"};
+        /* Only overlay effects run while the output is being rendered */
+        bool gpu = (type == OUTPUT_EFFECT_OVERLAY);
+
+        begin_stage(profiler, names[type], gpu);
+        effects[type].for_each([&] (auto effect)
+        {
+            begin_stage(profiler, effect->target_type(), gpu);
+            (*effect)();
+            end_stage(profiler);
+        });
+        end_stage(profiler);
     }
 };
 
@@ -262,6 +456,7 @@ struct postprocessing_manager_t
 {
     using post_container_t = wf::safe_list_t<post_hook_t*>;
     post_container_t post_effects;
+    frame_profiler_t *profiler = nullptr;
     wf::framebuffer_base_t post_buffers[3];
     /* Buffer to which other operations render to */
     static constexpr uint32_t default_out_buffer = 0;
@@ -349,7 +544,9 @@ struct postprocessing_manager_t
             next_buffer.allocate(output_width, output_height);
             OpenGL::render_end();
 
+            begin_stage(profiler, post->target_type(), true);
             (*post)(post_buffers[last_buffer_idx], next_buffer);
+            end_stage(profiler);
 
             last_buffer_idx  = next_buffer_idx;
             next_buffer_idx ^= 0b11; // alternate 1 and 2
@@ -492,6 +689,152 @@ class depth_buffer_manager_t : public noncopyable_t
     std::vector<depth_buffer_t> buffers;
 };
 
+/**
+ * Keeps track of which views on the output are fully covered by opaque views
+ * above them. Occluded views still receive frame callbacks, but at the much
+ * lower rate given by core/occluded_frame_rate, so that hidden clients do not
+ * keep rendering at the full refresh rate.
+ */
+class occlusion_tracker_t : public noncopyable_t
+{
+  public:
+    occlusion_tracker_t(output_t *output)
+    {
+        this->output = output;
+    }
+
+    /**
+     * Start a new pass over the visible views of the output.
+     *
+     * @param enabled Whether occlusion should be calculated at all. Custom
+     *   renderers may draw views which are normally covered, so in that case
+     *   all views are considered visible.
+     */
+    void begin(bool enabled)
+    {
+        this->enabled = enabled;
+        ++pass_counter;
+        covered.clear();
+        now = get_current_time();
+    }
+
+    /**
+     * Update the occlusion state of a mapped view. Views must be visited in
+     * their stacking order, from the topmost to the bottommost one.
+     *
+     * @return Whether the view should receive frame callbacks in this frame.
+     */
+    bool update_view(wayfire_view view)
+    {
+        auto& state = states[view.get()];
+        state.last_seen = pass_counter;
+
+        bool occluded = false;
+        if (enabled && view->is_visible())
+        {
+            wf::region_t visible{output->get_relative_geometry()};
+            visible &= view->get_bounding_box();
+            visible ^= covered;
+            occluded = visible.empty();
+
+            covered |= view->get_transformed_opaque_region();
+        }
+
+        if (occluded != state.occluded)
+        {
+            state.occluded = occluded;
+            /* Give the view a full interval before throttling kicks in */
+            state.last_frame_done = now;
+            changed_views.push_back(view);
+        }
+
+        int rate = occluded_frame_rate;
+        if (!occluded || (rate <= 0))
+        {
+            return true;
+        }
+
+        has_throttled_views = true;
+        if (now - state.last_frame_done >= 1000u / rate)
+        {
+            state.last_frame_done = now;
+
+            return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * Finish the pass: forget about views which were not visited, and make
+     * sure throttled views get their next frame even if nothing else
+     * triggers a repaint.
+     */
+    void end()
+    {
+        /* Signals are emitted only after the pass, because the views are
+         * visited while walking the layers, which must not be modified in
+         * the meantime. */
+        for (auto& view : changed_views)
+        {
+            view_occlusion_changed_signal data;
+            data.view     = view;
+            data.occluded = states[view.get()].occluded;
+            view->emit_signal("occlusion-changed", &data);
+            output->emit_signal("view-occlusion-changed", &data);
+        }
+
+        changed_views.clear();
+        for (auto it = states.begin(); it != states.end();)
+        {
+            if (it->second.last_seen != pass_counter)
+            {
+                it = states.erase(it);
+            } else
+            {
+                ++it;
+            }
+        }
+
+        int rate = occluded_frame_rate;
+        if (has_throttled_views && (rate > 0) && !throttle_timer.is_connected())
+        {
+            /* A timeout of 0 would fire right away on every frame */
+            throttle_timer.set_timeout(std::max(1, 1000 / rate), [=] ()
+            {
+                output->render->schedule_redraw();
+            });
+        }
+
+        has_throttled_views = false;
+    }
+
+  private:
+    struct view_state_t
+    {
+        bool occluded = false;
+        /* When the view last received frame callbacks while occluded, in ms */
+        uint32_t last_frame_done = 0;
+        /* The pass in which the view was last visited */
+        uint64_t last_seen = 0;
+    };
+
+    output_t *output;
+    std::unordered_map<wf::view_interface_t*, view_state_t> states;
+    /* Views whose occlusion state changed in the current pass */
+    std::vector<wayfire_view> changed_views;
+
+    bool enabled = true;
+    bool has_throttled_views = false;
+    uint64_t pass_counter = 0;
+    uint32_t now = 0;
+    /* The opaque region of all views visited in the current pass */
+    wf::region_t covered;
+
+    wf::wl_timer throttle_timer;
+    wf::option_wrapper_t<int> occluded_frame_rate{"core/occluded_frame_rate"};
+};
+
 class wf::render_manager::impl
 {
   public:
@@ -506,10 +849,17 @@ class wf::render_manager::impl
     std::unique_ptr<effect_hook_manager_t> effects;
     std::unique_ptr<postprocessing_manager_t> postprocessing;
     std::unique_ptr<depth_buffer_manager_t> depth_buffer_manager;
+    std::unique_ptr<occlusion_tracker_t> occlusion_tracker;
+    /* Only created with --profile-frames */
+    std::unique_ptr<frame_profiler_t> profiler;
 
     wf::option_wrapper_t<wf::color_t> background_color_opt;
     wf::option_wrapper_t<int> max_render_time_opt;
 
+    /* Emitted for every workspace stream update */
+    const wf::signal_id_t stream_pre_signal{"workspace-stream-pre"};
+    const wf::signal_id_t stream_post_signal{"workspace-stream-post"};
+
     impl(output_t *o) :
         output(o)
     {
@@ -517,6 +867,13 @@ class wf::render_manager::impl
         effects = std::make_unique<effect_hook_manager_t>();
         postprocessing = std::make_unique<postprocessing_manager_t>(o);
         depth_buffer_manager = std::make_unique<depth_buffer_manager_t>();
+        occlusion_tracker    = std::make_unique<occlusion_tracker_t>(o);
+        if (runtime_config.profile_frames)
+        {
+            profiler = std::make_unique<frame_profiler_t>(o->handle->name);
+            effects->profiler = profiler.get();
+            postprocessing->profiler = profiler.get();
+        }
 
         on_present.set_callback([&] (void *data)
         {
@@ -614,6 +971,19 @@ class wf::render_manager::impl
         output_damage->schedule_repaint();
     }
 
+    animation_driver_list_t animation_drivers;
+
+    void add_animation_driver(animation_driver_t *driver)
+    {
+        animation_drivers.add(driver);
+        output_damage->schedule_repaint();
+    }
+
+    void rem_animation_driver(animation_driver_t *driver)
+    {
+        animation_drivers.remove(driver);
+    }
+
     int output_inhibit_counter = 0;
     void add_inhibit(bool add)
     {
@@ -693,7 +1063,10 @@ class wf::render_manager::impl
     {
         if (renderer)
         {
+            begin_stage(profiler.get(), renderer.target_type(), true);
             renderer(postprocessing->get_target_framebuffer());
+            end_stage(profiler.get());
+
             /* TODO: let custom renderers specify what they want to repaint... */
             swap_damage |= output_damage->get_wlr_damage_box();
         } else
@@ -730,7 +1103,13 @@ class wf::render_manager::impl
      */
     void paint()
     {
+        if (profiler)
+        {
+            profiler->begin_frame();
+        }
+
         /* Part 1: frame setup: query damage, etc. */
+        animation_drivers.run();
         effects->run_effects(OUTPUT_EFFECT_PRE);
         effects->run_effects(OUTPUT_EFFECT_DAMAGE);
 
@@ -738,15 +1117,25 @@ class wf::render_manager::impl
         if (!output_damage->make_current(needs_swap))
         {
             wlr_output_rollback(output->handle);
+            if (profiler)
+            {
+                profiler->discard_frame();
+            }
 
             return;
         }
 
-        if (!needs_swap && !constant_redraw_counter)
+        if (!needs_swap && !constant_redraw_counter &&
+            !animation_drivers.needs_frame())
         {
             /* Optimization: the output doesn't need a swap (so isn't damaged),
-             * and no plugin wants custom redrawing - we can just skip the whole
-             * repaint */
+             * and no plugin wants custom redrawing or animates - we can just
+             * skip the whole repaint */
+            if (profiler)
+            {
+                profiler->discard_frame();
+            }
+
             post_paint();
             wlr_output_rollback(output->handle);
 
@@ -754,10 +1143,17 @@ class wf::render_manager::impl
         }
 
         update_bound_output();
+        OpenGL::reset_draw_call_count();
+        if (profiler)
+        {
+            profiler->begin_gpu_frame();
+        }
 
         /* Part 2: call the renderer, which sets swap_damage and
          * draws the scenegraph */
+        begin_stage(profiler.get(), "render", true);
         render_output();
+        end_stage(profiler.get());
 
         /* Part 3: finalize the scene: overlay effects and sw cursors */
         effects->run_effects(OUTPUT_EFFECT_OVERLAY);
@@ -767,11 +1163,14 @@ class wf::render_manager::impl
             swap_damage |= output_damage->get_wlr_damage_box();
         }
 
+        begin_stage(profiler.get(), "cursors", true);
         OpenGL::render_begin(postprocessing->get_target_framebuffer());
         wlr_output_render_software_cursors(output->handle, swap_damage.to_pixman());
         OpenGL::render_end();
+        end_stage(profiler.get());
 
         /* Part 4: postprocessing effects */
+        begin_stage(profiler.get(), "postprocessing", true);
         postprocessing->run_post_effects();
         if (output_inhibit_counter)
         {
@@ -781,11 +1180,25 @@ class wf::render_manager::impl
             OpenGL::render_end();
         }
 
+        end_stage(profiler.get());
+
         /* Part 5: finalize frame: swap buffers, send frame_done, etc */
+        if (runtime_config.damage_debug)
+        {
+            LOGD("Output ", output->handle->name, ": ",
+                OpenGL::get_draw_call_count(), " draw calls");
+        }
+
         OpenGL::unbind_output(output);
+        begin_stage(profiler.get(), "swap", false);
         output_damage->swap_buffers(swap_damage);
+        end_stage(profiler.get());
         swap_damage.clear();
         post_paint();
+        if (profiler)
+        {
+            profiler->end_frame();
+        }
     }
 
     /**
@@ -795,68 +1208,64 @@ class wf::render_manager::impl
     {
         effects->run_effects(OUTPUT_EFFECT_POST);
 
-        if (constant_redraw_counter)
+        if (constant_redraw_counter || animation_drivers.needs_next_frame())
         {
             output_damage->schedule_repaint();
         }
     }
 
     /**
-     * Send frame_done to clients.
+     * Send frame_done to clients. Views which are fully covered by opaque
+     * views above them receive throttled frame callbacks.
      */
     void send_frame_done()
     {
-        /* TODO: do this only if the view isn't fully occluded by another */
-        std::vector<wayfire_view> visible_views;
-        if (renderer)
-        {
-            visible_views = output->workspace->get_views_in_layer(
-                wf::VISIBLE_LAYERS);
-        } else
-        {
-            visible_views = output->workspace->get_views_on_workspace(
-                output->workspace->get_current_workspace(),
-                wf::MIDDLE_LAYERS);
-
-            // send to all panels/backgrounds/etc
-            auto additional_views = output->workspace->get_views_in_layer(
-                wf::BELOW_LAYERS | wf::ABOVE_LAYERS);
-
-            visible_views.insert(visible_views.end(),
-                additional_views.begin(), additional_views.end());
-        }
+        auto cws = output->workspace->get_current_workspace();
 
         timespec repaint_ended;
         clockid_t presentation_clock =
             wlr_backend_get_presentation_clock(wf::get_core_impl().backend);
         clock_gettime(presentation_clock, &repaint_ended);
-        for (auto& v : visible_views)
+
+        auto send_to_view = [&] (wayfire_view view)
         {
-            for (auto& view : v->enumerate_views())
+            if (!view->is_mapped() || !occlusion_tracker->update_view(view))
             {
-                if (!view->is_mapped())
-                {
-                    continue;
-                }
+                return;
+            }
 
-                for (auto& child : view->enumerate_surfaces())
-                {
-                    child.surface->send_frame_done(repaint_ended);
-                }
+            for (auto& child : view->enumerate_surfaces())
+            {
+                child.surface->send_frame_done(repaint_ended);
             }
+        };
+
+        /* Visit the views in their stacking order, so that occlusion can be
+         * calculated. Views which are not on the current workspace are not
+         * visible unless a custom renderer is active. */
+        occlusion_tracker->begin(!renderer);
+        auto visit = [&] (wayfire_view v) { v->for_each_view(send_to_view); };
+        if (renderer)
+        {
+            output->workspace->for_each_view_in_layer(wf::VISIBLE_LAYERS, visit);
+        } else
+        {
+            output->workspace->for_each_view_on_workspace(cws,
+                wf::VISIBLE_LAYERS, visit);
         }
+
+        occlusion_tracker->end();
     }
 
     /* Workspace stream implementation */
     void workspace_stream_start(workspace_stream_t& stream)
     {
         stream.running = true;
-        stream.scale_x = stream.scale_y = 1;
 
         /* damage the whole workspace region, so that we get a full repaint
          * when updating the workspace */
         output_damage->damage(output_damage->get_ws_box(stream.ws));
-        workspace_stream_update(stream, 1, 1);
+        workspace_stream_update(stream, stream.scale_x, stream.scale_y);
     }
 
     /**
@@ -995,49 +1404,96 @@ class wf::render_manager::impl
     void check_schedule_surfaces(workspace_stream_repaint_t& repaint,
         workspace_stream_t& stream)
     {
-        auto views = output->workspace->get_views_on_workspace(stream.ws,
-            wf::VISIBLE_LAYERS);
-
         schedule_drag_icon(repaint);
-        for (auto& v : views)
+        if (repaint.ws_damage.empty())
+        {
+            return;
+        }
+
+        auto schedule_view = [&] (wayfire_view view)
         {
-            for (auto& view : v->enumerate_views(false))
+            wf::point_t view_delta{0, 0};
+            if (!view->is_visible() || repaint.ws_damage.empty())
             {
-                wf::point_t view_delta{0, 0};
-                if (!view->is_visible() || repaint.ws_damage.empty())
-                {
-                    continue;
-                }
+                return;
+            }
 
-                if (view->role == VIEW_ROLE_DESKTOP_ENVIRONMENT)
-                {
-                    view_delta = {repaint.ws_dx, repaint.ws_dy};
-                }
+            if (view->role == VIEW_ROLE_DESKTOP_ENVIRONMENT)
+            {
+                view_delta = {repaint.ws_dx, repaint.ws_dy};
+            }
 
-                /* We use the snapshot of a view on either of the following
-                 * conditions:
-                 *
-                 * 1. The view has a transform
-                 * 2. The view is visible, but not mapped
-                 *    => it is snapshotted and kept alive by some plugin
-                 */
-                if (view->has_transformer() || !view->is_mapped())
-                {
-                    /* Snapshotted views include all of their subsurfaces, so we
-                     * don't recursively go into subsurfaces. */
-                    schedule_snapshotted_view(repaint, view, view_delta);
-                } else
+            /* We use the snapshot of a view on either of the following
+             * conditions:
+             *
+             * 1. The view has a transform
+             * 2. The view is visible, but not mapped
+             *    => it is snapshotted and kept alive by some plugin
+             */
+            if (view->has_transformer() || !view->is_mapped())
+            {
+                /* Snapshotted views include all of their subsurfaces, so we
+                 * don't recursively go into subsurfaces. */
+                schedule_snapshotted_view(repaint, view, view_delta);
+            } else
+            {
+                /* Make sure view position is relative to the workspace
+                 * being rendered */
+                auto obox = view->get_output_geometry() + view_delta;
+                for (auto& child : view->enumerate_surfaces({obox.x, obox.y}))
                 {
-                    /* Make sure view position is relative to the workspace
-                     * being rendered */
-                    auto obox = view->get_output_geometry() + view_delta;
-                    for (auto& child : view->enumerate_surfaces({obox.x, obox.y}))
-                    {
-                        schedule_surface(repaint, child.surface, child.position);
-                    }
+                    schedule_surface(repaint, child.surface, child.position);
                 }
             }
+        };
+
+        output->workspace->for_each_view_on_workspace(stream.ws,
+            wf::VISIBLE_LAYERS, [&] (wayfire_view v)
+        {
+            v->for_each_view(schedule_view, false);
+
+            /* Everything below is already covered */
+            return repaint.ws_damage.empty();
+        });
+    }
+
+    /**
+     * Stream scales are rounded up to a multiple of 1 / STREAM_SCALE_STEPS, so
+     * that animations which continuously change the displayed size of a stream
+     * do not reallocate and fully repaint it on every frame.
+     */
+    static constexpr int STREAM_SCALE_STEPS = 8;
+    static float quantize_stream_scale(float scale)
+    {
+        /* Also catches NaN */
+        if (!(scale > 0) || (scale >= 1))
+        {
+            return 1;
         }
+
+        return std::ceil(scale * STREAM_SCALE_STEPS) / STREAM_SCALE_STEPS;
+    }
+
+    /**
+     * Grow the damage of a downscaled stream so that stream pixels which are
+     * only partially covered by the damage are repainted as a whole.
+     */
+    void expand_scaled_damage(workspace_stream_repaint_t& repaint,
+        workspace_stream_t& stream, float scale)
+    {
+        /* One stream pixel spans at most 1 / scale logical pixels, and linear
+         * filtering reads one more pixel on each side */
+        int margin = std::ceil(2.0 / scale);
+
+        wf::region_t grown;
+        for (const auto& rect : repaint.ws_damage)
+        {
+            auto box = wlr_box_from_pixman_box(rect);
+            grown |= wf::geometry_t{box.x - margin, box.y - margin,
+                box.width + 2 * margin, box.height + 2 * margin};
+        }
+
+        repaint.ws_damage = grown & output_damage->get_ws_box(stream.ws);
     }
 
     /**
@@ -1049,31 +1505,62 @@ class wf::render_manager::impl
         workspace_stream_repaint_t repaint;
         repaint.ws_damage = output_damage->get_ws_damage(stream.ws);
 
+        /* The default streams have no buffers of their own */
+        bool own_buffer = (stream.buffer.tex != 0);
+        if (own_buffer)
+        {
+            workspace_stream_cache_t::get().touch(&stream);
+        }
+
+        /* The stream is rendered with the same scale on both axes. Use the
+         * larger one, so that it is not undersampled in either direction.
+         * The default streams render directly to the output and are never
+         * scaled. */
+        float scale = quantize_stream_scale(std::max(scale_x, scale_y));
+        if (!own_buffer)
+        {
+            scale = 1;
+        }
+
+        if ((scale != stream.scale_x) || (scale != stream.scale_y))
+        {
+            stream.scale_x = stream.scale_y = scale;
+            /* The buffer is reallocated with the new size, so its contents
+             * need to be repainted */
+            repaint.ws_damage |= output_damage->get_ws_box(stream.ws);
+        }
+
         /* we don't have to update anything */
         if (repaint.ws_damage.empty())
         {
             return repaint;
         }
 
-        if ((scale_x != stream.scale_x) || (scale_y != stream.scale_y))
+        if (scale < 1)
         {
-            /* FIXME: enable scaled rendering */
-            // stream->scale_x = scale_x;
-            // stream->scale_y = scale_y;
-
-            // ws_damage |= get_damage_box();
+            expand_scaled_damage(repaint, stream, scale);
         }
 
         OpenGL::render_begin();
-        stream.buffer.allocate(output->handle->width, output->handle->height);
+        stream.buffer.allocate(
+            std::max(1, (int)std::ceil(output->handle->width * scale)),
+            std::max(1, (int)std::ceil(output->handle->height * scale)));
         OpenGL::render_end();
 
         repaint.fb = postprocessing->get_target_framebuffer();
-        if ((stream.buffer.tex != 0))
+        if (own_buffer)
         {
-            /* Use the workspace buffers */
+            /* Account for a newly allocated or resized buffer */
+            workspace_stream_cache_t::get().touch(&stream);
+
+            /* Use the workspace buffers. The geometry stays the same, so
+             * rendering and damage stay in output-local logical coordinates,
+             * and the scale maps them onto the smaller buffer. */
             repaint.fb.fb  = stream.buffer.fb;
             repaint.fb.tex = stream.buffer.tex;
+            repaint.fb.viewport_width  = stream.buffer.viewport_width;
+            repaint.fb.viewport_height = stream.buffer.viewport_height;
+            repaint.fb.scale *= scale;
         }
 
         auto g   = output->get_relative_geometry();
@@ -1149,7 +1636,7 @@ class wf::render_manager::impl
 
         {
             stream_signal_t data(stream.ws, repaint.ws_damage, repaint.fb);
-            output->render->emit_signal("workspace-stream-pre", &data);
+            output->render->emit_signal(stream_pre_signal, &data);
         }
 
         check_schedule_surfaces(repaint, stream);
@@ -1167,13 +1654,14 @@ class wf::render_manager::impl
         unschedule_drag_icon();
         {
             stream_signal_t data(stream.ws, repaint.ws_damage, repaint.fb);
-            output->render->emit_signal("workspace-stream-post", &data);
+            output->render->emit_signal(stream_post_signal, &data);
         }
     }
 
     void workspace_stream_stop(workspace_stream_t& stream)
     {
         stream.running = false;
+        workspace_stream_cache_t::get().stream_stopped(&stream);
     }
 };
 
@@ -1196,6 +1684,16 @@ wf::region_t render_manager::get_swap_damage()
     return pimpl->get_swap_damage();
 }
 
+void render_manager::add_animation_driver(animation_driver_t *driver)
+{
+    pimpl->add_animation_driver(driver);
+}
+
+void render_manager::rem_animation_driver(animation_driver_t *driver)
+{
+    pimpl->rem_animation_driver(driver);
+}
+
 void render_manager::schedule_redraw()
 {
     pimpl->output_damage->schedule_repaint();
@@ -1269,7 +1767,7 @@ void render_manager::workspace_stream_start(workspace_stream_t& stream)
 void render_manager::workspace_stream_update(workspace_stream_t& stream,
     float scale_x, float scale_y)
 {
-    pimpl->workspace_stream_update(stream);
+    pimpl->workspace_stream_update(stream, scale_x, scale_y);
 }
 
 void render_manager::workspace_stream_stop(workspace_stream_t& stream)
@@ -0,0 +1,224 @@
+#ifndef WF_OUTPUT_STACK_LIST_HPP
+#define WF_OUTPUT_STACK_LIST_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace wf
+{
+/** Keeps the positions of the elements of a stack_list_t in a hash map. */
+template<class Key>
+class hashed_stack_positions_t
+{
+  public:
+    size_t get(Key key, size_t not_found) const
+    {
+        auto it = positions.find(key);
+        return it == positions.end() ? not_found : it->second;
+    }
+
+    void set(Key key, size_t position)
+    {
+        positions[key] = position;
+    }
+
+    void erase(Key key)
+    {
+        positions.erase(key);
+    }
+
+  private:
+    std::unordered_map<Key, size_t> positions;
+};
+
+/**
+ * Keeps the positions of the elements of a stack_list_t in the elements
+ * themselves, in a size_t member called stack_position. Updating positions
+ * is then a plain store, which makes restacking long lists much cheaper.
+ *
+ * An element can be in only one such list at a time.
+ */
+template<class Key>
+class intrusive_stack_positions_t
+{
+  public:
+    size_t get(Key key, size_t not_found) const
+    {
+        return key->stack_position < not_found ? key->stack_position : not_found;
+    }
+
+    void set(Key key, size_t position)
+    {
+        key->stack_position = position;
+    }
+
+    void erase(Key key)
+    {
+        key->stack_position = -1;
+    }
+};
+
+/**
+ * A contiguous list of smart pointers in stacking order, from top to bottom.
+ *
+ * Besides the elements, the list tracks the position of each element, so
+ * that looking up an element is O(1). Restacking an element costs O(k), where
+ * k is the number of elements it passes, because they all have to be shifted
+ * and re-indexed.
+ *
+ * Elements are identified by the raw pointer returned by their get().
+ */
+template<class T,
+    class Positions =
+        hashed_stack_positions_t<decltype(std::declval<const T&>().get())>>
+class stack_list_t
+{
+  public:
+    using key_t = decltype(std::declval<const T&>().get());
+    using const_iterator = typename std::vector<T>::const_iterator;
+
+    const_iterator begin() const
+    {
+        return items.begin();
+    }
+
+    const_iterator end() const
+    {
+        return items.end();
+    }
+
+    size_t size() const
+    {
+        return items.size();
+    }
+
+    bool empty() const
+    {
+        return items.empty();
+    }
+
+    const T& operator [](size_t idx) const
+    {
+        return items[idx];
+    }
+
+    /** @return The position of the element, or size() if not in the list */
+    size_t find(key_t key) const
+    {
+        size_t pos = positions.get(key, items.size());
+        /* Intrusive positions may belong to another list */
+        return (pos < items.size() && items[pos].get() == key) ?
+               pos : items.size();
+    }
+
+    bool contains(key_t key) const
+    {
+        return find(key) < items.size();
+    }
+
+    /** Insert an element which is not in the list yet at the given position */
+    void insert(size_t pos, T item)
+    {
+        assert(!contains(item.get()));
+        items.insert(items.begin() + pos, std::move(item));
+        reindex(pos, items.size());
+    }
+
+    void push_front(T item)
+    {
+        insert(0, std::move(item));
+    }
+
+    void push_back(T item)
+    {
+        insert(items.size(), std::move(item));
+    }
+
+    /** Remove the element from the list. No-op if it is not in the list. */
+    void remove(key_t key)
+    {
+        size_t pos = find(key);
+        if (pos == items.size())
+        {
+            return;
+        }
+
+        positions.erase(key);
+        items.erase(items.begin() + pos);
+        reindex(pos, items.size());
+    }
+
+    /** Move the element to the top. */
+    void raise_to_front(key_t key)
+    {
+        move_to(find(key), 0);
+    }
+
+    /** Move the element to the bottom. */
+    void lower_to_back(key_t key)
+    {
+        move_to(find(key), items.size() - 1);
+    }
+
+    /** Move @element so that it is directly above @below. */
+    void move_above(key_t element, key_t below)
+    {
+        size_t from = find(element);
+        size_t pos  = find(below);
+        move_to(from, from < pos ? pos - 1 : pos);
+    }
+
+    /** Move @element so that it is directly below @above. */
+    void move_below(key_t element, key_t above)
+    {
+        size_t from = find(element);
+        size_t pos  = find(above);
+        move_to(from, from < pos ? pos : pos + 1);
+    }
+
+    /**
+     * Move all elements which satisfy the predicate to the front, keeping
+     * the relative order of the elements in both groups.
+     */
+    template<class Predicate>
+    void stable_partition(Predicate pred)
+    {
+        std::stable_partition(items.begin(), items.end(), pred);
+        reindex(0, items.size());
+    }
+
+  private:
+    std::vector<T> items;
+    Positions positions;
+
+    void reindex(size_t from, size_t to)
+    {
+        for (size_t i = from; i < to; i++)
+        {
+            positions.set(items[i].get(), i);
+        }
+    }
+
+    /** Move the element at position @from to position @to. */
+    void move_to(size_t from, size_t to)
+    {
+        assert(from < items.size() && to < items.size());
+        if (from < to)
+        {
+            std::rotate(items.begin() + from, items.begin() + from + 1,
+                items.begin() + to + 1);
+            reindex(from, to + 1);
+        } else if (to < from)
+        {
+            std::rotate(items.begin() + to, items.begin() + from,
+                items.begin() + from + 1);
+            reindex(to, from + 1);
+        }
+    }
+};
+}
+
+#endif /* end of include guard: WF_OUTPUT_STACK_LIST_HPP */
@@ -5,78 +5,22 @@
 #include <wayfire/render-manager.hpp>
 #include <wayfire/signal-definitions.hpp>
 #include <wayfire/opengl.hpp>
-#include <list>
+#include <vector>
 #include <algorithm>
-#include <wayfire/nonstd/reverse.hpp>
+#include <unordered_set>
 #include <wayfire/util/log.hpp>
+#include "stack-list.hpp"
 
 namespace wf
 {
-/** Find a smart pointer inside a list */
-template<class Haystack, class Needle>
-typename std::list<Haystack>::iterator find_in(std::list<Haystack>& hay,
-    const Needle& needle)
-{
-    return std::find_if(std::begin(hay), std::end(hay), [=] (const auto& elem)
-    {
-        return elem.get() == needle.get();
-    });
-}
-
-/** Bring to front or lower to back inside a container of smart pointers */
-template<class Haystack, class Needle>
-void raise_to_front(std::list<Haystack>& hay, const Needle& needle,
-    bool reverse = false)
-{
-    auto it = find_in(hay, needle);
-    hay.splice(reverse ? hay.end() : hay.begin(), hay, it);
-}
-
-/** Reorder list so that @element is directly above @below. */
-template<class Haystack, class Needle>
-void reorder_above(
-    std::list<Haystack>& list, const Needle& element, const Needle& below)
-{
-    auto element_it = find_in(list, element);
-    auto pos = find_in(list, below);
-    list.splice(pos, list, element_it);
-}
-
-/** Reorder list so that @element is directly below @above. */
-template<class Haystack, class Needle>
-void reorder_below(
-    std::list<Haystack>& list, const Needle& element, const Needle& above)
-{
-    auto element_it = find_in(list, element);
-    auto pos = find_in(list, above);
-    assert(pos != list.end());
-    list.splice(std::next(pos), list, element_it);
-}
-
-/**
- * Remove needle from haystack, where both needle and elements in haystack are
- * smart pointers.
- */
-template<class Haystack, class Needle>
-void remove_from(Haystack& haystack, Needle& n)
-{
-    auto it = std::remove_if(std::begin(haystack), std::end(haystack),
-        [=] (const auto& contained)
-    {
-        return contained.get() == n.get();
-    });
-
-    haystack.erase(it, std::end(haystack));
-}
-
 struct layer_container_t;
 /**
  * Implementation of the sublayer struct.
  */
 struct sublayer_t
 {
-    /** A list of the views in the sublayer */
-    std::list<wayfire_view> views;
+    /** The views in the sublayer, from top to bottom */
+    stack_list_t<wayfire_view> views;
 
     /** The actual layer this sublayer belongs to */
     nonstd::observer_ptr<layer_container_t> layer;
@@ -90,14 +34,15 @@ struct sublayer_t
      * elsewhere.
      */
     bool is_single_view;
+
+    /** The position of the sublayer in its sublayer_container_t */
+    size_t stack_position = -1;
 };
 
 class layer_view_data_t : public custom_data_t
 {
   public:
     nonstd::observer_ptr<sublayer_t> sublayer;
-    /* Promoted to the fullscreen layer? */
-    bool is_promoted = false;
 };
 
 /**
@@ -108,7 +53,10 @@ struct layer_container_t
     /** The layer of the container */
     layer_t layer;
 
-    using sublayer_container_t = std::list<std::unique_ptr<sublayer_t>>;
+    /* Sublayers are stored contiguously from top to bottom. Restacking
+     * rotates the affected range instead of relinking list nodes. */
+    using sublayer_container_t = stack_list_t<std::unique_ptr<sublayer_t>,
+        intrusive_stack_positions_t<sublayer_t*>>;
     /** List of sublayers docked below */
     sublayer_container_t below;
     /** List of floating sublayers */
@@ -120,7 +68,7 @@ struct layer_container_t
     {
         for (auto container : {& below, & floating, & above})
         {
-            remove_from(*container, sublayer);
+            container->remove(sublayer.get());
         }
     }
 };
@@ -133,6 +81,13 @@ class output_layer_manager_t
 {
     layer_container_t layers[TOTAL_LAYERS];
 
+    /**
+     * Views promoted to the fullscreen layer. Kept separately from the layer
+     * data so that walking the layers does not need a custom data lookup
+     * per view. There is at most one promoted view per workspace.
+     */
+    std::vector<wayfire_view> promoted_views;
+
   public:
     output_layer_manager_t()
     {
@@ -182,7 +137,8 @@ class output_layer_manager_t
 
         view->damage();
 
-        remove_from(sublayer->views, view);
+        set_promoted(view, false);
+        sublayer->views.remove(view.get());
         if (sublayer->is_single_view)
         {
             sublayer->layer->remove_sublayer(sublayer);
@@ -214,15 +170,15 @@ class output_layer_manager_t
         switch (mode)
         {
           case SUBLAYER_DOCKED_BELOW:
-            layer.below.emplace_back(std::move(sublayer));
+            layer.below.push_back(std::move(sublayer));
             break;
 
           case SUBLAYER_DOCKED_ABOVE:
-            layer.above.emplace_front(std::move(sublayer));
+            layer.above.push_front(std::move(sublayer));
             break;
 
           case SUBLAYER_FLOATING:
-            layer.floating.emplace_front(std::move(sublayer));
+            layer.floating.push_front(std::move(sublayer));
             break;
         }
 
@@ -246,10 +202,49 @@ class output_layer_manager_t
         assert(sublayer);
         if (sublayer->mode == SUBLAYER_FLOATING)
         {
-            raise_to_front(sublayer->layer->floating, sublayer);
+            sublayer->layer->floating.raise_to_front(sublayer.get());
         }
 
-        raise_to_front(sublayer->views, view);
+        sublayer->views.raise_to_front(view.get());
+    }
+
+    /**
+     * Bring all of the given views to the front. The result is the same as
+     * calling bring_to_front() for each view from bottom to top, but each
+     * affected list is reordered only once.
+     *
+     * Precondition: all views are in some sublayer
+     */
+    void bring_to_front(const std::vector<wayfire_view>& views)
+    {
+        std::unordered_set<wf::view_interface_t*> raised_views;
+        std::unordered_set<sublayer_t*> raised_sublayers;
+        for (auto& view : views)
+        {
+            view->damage();
+
+            auto sublayer = get_view_sublayer(view);
+            assert(sublayer);
+            raised_views.insert(view.get());
+            raised_sublayers.insert(sublayer.get());
+        }
+
+        for (auto& sublayer : raised_sublayers)
+        {
+            sublayer->views.stable_partition([&] (wayfire_view view)
+            {
+                return raised_views.count(view.get());
+            });
+        }
+
+        for (auto& layer : layers)
+        {
+            layer.floating.stable_partition(
+                [&] (const std::unique_ptr<sublayer_t>& sublayer)
+            {
+                return raised_sublayers.count(sublayer.get());
+            });
+        }
     }
 
     wayfire_view get_front_view(wf::layer_t layer)
@@ -274,7 +269,7 @@ class output_layer_manager_t
 
         if (view_sublayer == below_sublayer)
         {
-            reorder_above(view_sublayer->views, view, below);
+            view_sublayer->views.move_above(view.get(), below.get());
 
             return;
         }
@@ -285,8 +280,9 @@ class output_layer_manager_t
             return;
         }
 
-        reorder_above(view_sublayer->layer->floating, view_sublayer, below_sublayer);
-        raise_to_front(view_sublayer->views, view, true); // bring to back == reverse
+        view_sublayer->layer->floating.move_above(view_sublayer.get(),
+            below_sublayer.get());
+        view_sublayer->views.lower_to_back(view.get());
     }
 
     /** Precondition: view and above are in the same layer */
@@ -300,7 +296,7 @@ class output_layer_manager_t
 
         if (view_sublayer == above_sublayer)
         {
-            reorder_below(view_sublayer->views, view, above);
+            view_sublayer->views.move_below(view.get(), above.get());
 
             return;
         }
@@ -311,12 +307,40 @@ class output_layer_manager_t
             return;
         }
 
-        reorder_below(view_sublayer->layer->floating, view_sublayer, above_sublayer);
-        raise_to_front(view_sublayer->views, view);
+        view_sublayer->layer->floating.move_below(view_sublayer.get(),
+            above_sublayer.get());
+        view_sublayer->views.raise_to_front(view.get());
+    }
+
+    bool is_promoted(wayfire_view view) const
+    {
+        return std::find(promoted_views.begin(), promoted_views.end(), view) !=
+               promoted_views.end();
+    }
+
+    void set_promoted(wayfire_view view, bool promoted)
+    {
+        auto it = std::find(promoted_views.begin(), promoted_views.end(), view);
+        if (promoted && (it == promoted_views.end()))
+        {
+            promoted_views.push_back(view);
+        } else if (!promoted && (it != promoted_views.end()))
+        {
+            promoted_views.erase(it);
+        }
+    }
+
+    /** Unpromote all promoted views which match the predicate */
+    template<class Predicate>
+    void unpromote_if(Predicate pred)
+    {
+        auto it = std::remove_if(promoted_views.begin(), promoted_views.end(),
+            pred);
+        promoted_views.erase(it, promoted_views.end());
     }
 
-    void push_views(std::vector<wayfire_view>& into, layer_t layer_e,
-        bool promoted)
+    bool visit_layer(layer_t layer_e, bool promoted,
+        const view_visitor_t& visitor)
     {
         auto& layer = this->layers[layer_index_from_mask(layer_e)];
         for (const auto& sublayers :
@@ -324,55 +348,73 @@ class output_layer_manager_t
         {
             for (const auto& sublayer : *sublayers)
             {
-                auto& container = sublayer->views;
-                std::copy_if(container.begin(), container.end(),
-                    std::back_inserter(into), [=] (wayfire_view view)
+                for (auto& view : sublayer->views)
                 {
-                    const auto& layer_data =
-                        view->get_data_safe<layer_view_data_t>();
-
-                    return layer_data->is_promoted == promoted;
-                });
+                    if ((is_promoted(view) == promoted) && visitor(view))
+                    {
+                        return true;
+                    }
+                }
             }
         }
+
+        return false;
     }
 
-    std::vector<wayfire_view> get_views_in_layer(uint32_t layers_mask)
+    bool for_each_view_in_layer(uint32_t layers_mask,
+        const view_visitor_t& visitor)
     {
-        std::vector<wayfire_view> views;
-        auto try_push = [&] (layer_t layer, bool promoted = false)
+        auto try_visit = [&] (layer_t layer, bool promoted = false)
         {
-            if (!(layer & layers_mask))
-            {
-                return;
-            }
-
-            push_views(views, layer, promoted);
+            return (layer & layers_mask) && visit_layer(layer, promoted, visitor);
         };
 
         /* Above fullscreen views */
         for (auto layer : {LAYER_DESKTOP_WIDGET, LAYER_LOCK, LAYER_UNMANAGED})
         {
-            try_push(layer);
+            if (try_visit(layer))
+            {
+                return true;
+            }
         }
 
         /* Fullscreen */
-        try_push(LAYER_WORKSPACE, true);
+        if (try_visit(LAYER_WORKSPACE, true))
+        {
+            return true;
+        }
 
         /* Below fullscreen */
         for (auto layer :
              {LAYER_TOP, LAYER_WORKSPACE, LAYER_BOTTOM, LAYER_BACKGROUND})
         {
-            try_push(layer);
+            if (try_visit(layer))
+            {
+                return true;
+            }
         }
 
+        return false;
+    }
+
+    std::vector<wayfire_view> get_views_in_layer(uint32_t layers_mask)
+    {
+        std::vector<wayfire_view> views;
+        for_each_view_in_layer(layers_mask, [&] (wayfire_view view)
+        {
+            views.push_back(view);
+        });
+
         return views;
     }
 
     std::vector<wayfire_view> get_promoted_views()
     {
         std::vector<wayfire_view> views;
-        push_views(views, LAYER_WORKSPACE, true);
+        visit_layer(LAYER_WORKSPACE, true, [&] (wayfire_view view)
+        {
+            views.push_back(view);
+        });
 
         return views;
     }
@@ -604,7 +646,13 @@ class output_viewport_manager_t
         return {vwidth, vheight};
     }
 
-    void set_workspace(wf::point_t nws,
+    /**
+     * Switch to the given workspace, and move all views except for the fixed
+     * ones, so that they keep their position relative to the workspace grid.
+     *
+     * @return Whether the workspace was changed.
+     */
+    bool set_workspace(wf::point_t nws,
         const std::vector<wayfire_view>& fixed_views)
     {
         if ((nws.x >= vwidth) || (nws.y >= vheight) || (nws.x < 0) || (nws.y < 0))
@@ -612,71 +660,55 @@ class output_viewport_manager_t
             LOGE("Attempt to set invalid workspace: ", nws,
                 " workspace grid size is ", vwidth, "x", vheight);
 
-            return;
+            return false;
         }
 
         if ((nws.x == current_vx) && (nws.y == current_vy))
         {
             output->refocus();
 
-            return;
+            return false;
         }
 
-        wf::workspace_changed_signal data;
-        data.old_viewport = {current_vx, current_vy};
-        data.new_viewport = {nws.x, nws.y};
-        data.output = output;
+        wf::point_t old_viewport = {current_vx, current_vy};
 
         /* The part below is tricky, because with the current architecture
          * we cannot make the viewport change look atomic, i.e the workspace
          * is changed first, and then all views are moved.
          *
          * We first change the viewport, and then adjust the position of the
-         * views. */
+         * views. Each view is moved on its own, with its own geometry signal:
+         * view positions are relative to the current workspace everywhere in
+         * the plugin API, so there is no single output-level offset which
+         * could be changed instead. */
         current_vx = nws.x;
         current_vy = nws.y;
 
         auto screen = output->get_screen_size();
-        auto dx     = (data.old_viewport.x - nws.x) * screen.width;
-        auto dy     = (data.old_viewport.y - nws.y) * screen.height;
+        auto dx     = (old_viewport.x - nws.x) * screen.width;
+        auto dy     = (old_viewport.y - nws.y) * screen.height;
 
-        for (auto& view : output->workspace->get_views_in_layer(MIDDLE_LAYERS))
+        std::unordered_set<wf::view_interface_t*> fixed;
+        for (auto& view : fixed_views)
         {
-            auto it = std::find(fixed_views.cbegin(), fixed_views.cend(), view);
-            if (it == fixed_views.end())
-            {
-                for (auto v : view->enumerate_views())
-                {
-                    v->move(v->get_wm_geometry().x + dx,
-                        v->get_wm_geometry().y + dy);
-                }
-            }
+            fixed.insert(view.get());
         }
 
-        /* unfocus view from last workspace */
-        output->focus_view(nullptr);
-        /* we iterate through views on current viewport from bottom to top
-         * that way we ensure that they will be focused before all others */
-        auto views = get_views_on_workspace(get_current_workspace(),
-            MIDDLE_LAYERS);
-
-        for (auto& view : wf::reverse(views))
+        for (auto& view : output->workspace->get_views_in_layer(MIDDLE_LAYERS))
         {
-            output->workspace->bring_to_front(view);
-        }
+            if (fixed.count(view.get()))
+            {
+                continue;
+            }
 
-        /* Focus last window */
-        auto it = std::find_if(views.begin(), views.end(),
-            [] (wayfire_view view)
-        {
-            return view->is_mapped() && !view->minimized;
-        });
-        if (it != views.end())
-        {
-            output->focus_view(*it);
+            for (auto v : view->enumerate_views())
+            {
+                auto wm = v->get_wm_geometry();
+                v->move(wm.x + dx, wm.y + dy);
+            }
         }
 
-        output->emit_signal("workspace-changed", &data);
+        return true;
     }
 };
 
@@ -880,16 +912,20 @@ class workspace_manager::impl
 
     void check_autohide_panels()
     {
-        auto fs_views = viewport_manager.get_promoted_views(
-            viewport_manager.get_current_workspace());
+        auto vp = viewport_manager.get_current_workspace();
+        bool has_fullscreen = layer_manager.visit_layer(LAYER_WORKSPACE, true,
+            [&] (wayfire_view view)
+        {
+            return viewport_manager.view_visible_on(view, vp);
+        });
 
-        if (fs_views.size() && !sent_autohide)
+        if (has_fullscreen && !sent_autohide)
         {
             sent_autohide = 1;
             output->emit_signal("fullscreen-layer-focused",
                 reinterpret_cast<signal_data_t*>(1));
             LOGD("autohide panels");
-        } else if (fs_views.empty() && sent_autohide)
+        } else if (!has_fullscreen && sent_autohide)
         {
             sent_autohide = 0;
             output->emit_signal("fullscreen-layer-focused",
@@ -900,8 +936,40 @@ class workspace_manager::impl
 
     void set_workspace(wf::point_t ws, const std::vector<wayfire_view>& fixed)
     {
-        viewport_manager.set_workspace(ws, fixed);
-        check_autohide_panels();
+        wf::workspace_changed_signal data;
+        data.old_viewport = viewport_manager.get_current_workspace();
+        data.new_viewport = ws;
+        data.output = output;
+
+        if (!viewport_manager.set_workspace(ws, fixed))
+        {
+            check_autohide_panels();
+
+            return;
+        }
+
+        /* unfocus view from last workspace */
+        output->focus_view(nullptr);
+
+        /* Raise the views on the new workspace in one batch, keeping their
+         * relative order, so that they will be focused before all others.
+         * This also updates the promoted views and the autohide panels. */
+        auto views = viewport_manager.get_views_on_workspace(ws, MIDDLE_LAYERS);
+        layer_manager.bring_to_front(views);
+        update_promoted_views();
+
+        /* Focus last window */
+        auto it = std::find_if(views.begin(), views.end(),
+            [] (wayfire_view view)
+        {
+            return view->is_mapped() && !view->minimized;
+        });
+        if (it != views.end())
+        {
+            output->focus_view(*it);
+        }
+
+        output->emit_signal("workspace-changed", &data);
     }
 
     void request_workspace(wf::point_t ws,
@@ -932,26 +1000,29 @@ class workspace_manager::impl
     void update_promoted_views()
     {
         auto vp = viewport_manager.get_current_workspace();
-        auto already_promoted = viewport_manager.get_promoted_views(vp);
-        for (auto& view : already_promoted)
+        layer_manager.unpromote_if([&] (wayfire_view view)
         {
-            view->get_data_safe<layer_view_data_t>()->is_promoted = false;
-        }
-
-        auto views = viewport_manager.get_views_on_workspace(
-            vp, LAYER_WORKSPACE);
+            return viewport_manager.view_visible_on(view, vp);
+        });
 
-        /* Do not consider unmapped views or views which are not visible */
-        auto it = std::remove_if(views.begin(), views.end(),
-            [] (wayfire_view view) -> bool
+        /* Find the topmost view on the workspace, not considering unmapped
+         * views or views which are not visible */
+        wayfire_view top_view = nullptr;
+        layer_manager.for_each_view_in_layer(LAYER_WORKSPACE,
+            [&] (wayfire_view view)
         {
-            return !view->is_mapped() || !view->is_visible();
+            if (view->is_mapped() && view->is_visible() &&
+                viewport_manager.view_visible_on(view, vp))
+            {
+                top_view = view;
+            }
+
+            return top_view != nullptr;
         });
-        views.erase(it, views.end());
 
-        if (!views.empty() && views.front()->fullscreen)
+        if (top_view && top_view->fullscreen)
         {
-            views.front()->get_data_safe<layer_view_data_t>()->is_promoted = true;
+            layer_manager.set_promoted(top_view, true);
         }
 
         check_autohide_panels();
@@ -1099,6 +1170,16 @@ std::vector<wayfire_view> workspace_manager::get_views_on_workspace(wf::point_t
     return pimpl->viewport_manager.get_views_on_workspace(ws, layer_mask);
 }
 
+bool workspace_manager::for_each_view_on_workspace(wf::point_t ws,
+    uint32_t layer_mask, view_visitor_t visitor)
+{
+    return pimpl->layer_manager.for_each_view_in_layer(layer_mask,
+        [&] (wayfire_view view)
+    {
+        return pimpl->viewport_manager.view_visible_on(view, ws) && visitor(view);
+    });
+}
+
 std::vector<wayfire_view> workspace_manager::get_views_on_workspace_sublayer(
     wf::point_t ws, nonstd::observer_ptr<sublayer_t> sublayer)
 {
@@ -1162,6 +1243,12 @@ std::vector<wayfire_view> workspace_manager::get_views_in_layer(uint32_t layers_
     return pimpl->layer_manager.get_views_in_layer(layers_mask);
 }
 
+bool workspace_manager::for_each_view_in_layer(uint32_t layers_mask,
+    view_visitor_t visitor)
+{
+    return pimpl->layer_manager.for_each_view_in_layer(layers_mask, visitor);
+}
+
 std::vector<wayfire_view> workspace_manager::get_views_in_sublayer(
     nonstd::observer_ptr<sublayer_t> sublayer)
 {
@@ -0,0 +1,156 @@
+#include "workspace-stream-cache.hpp"
+#include <wayfire/opengl.hpp>
+#include <wayfire/util/log.hpp>
+#include <algorithm>
+
+/* Created on first use and never destroyed, because streams may outlive
+ * static destructors */
+static wf::workspace_stream_cache_t *cache_instance = nullptr;
+
+wf::workspace_stream_cache_t& wf::workspace_stream_cache_t::get()
+{
+    if (!cache_instance)
+    {
+        cache_instance = new workspace_stream_cache_t();
+    }
+
+    return *cache_instance;
+}
+
+wf::workspace_stream_cache_t::workspace_stream_cache_t()
+{
+    memory_budget.set_callback([=] () { enforce_budget(); });
+}
+
+wf::workspace_stream_cache_t::entry_t*wf::workspace_stream_cache_t::find(
+    workspace_stream_t *stream)
+{
+    auto it = std::find_if(entries.begin(), entries.end(),
+        [=] (const entry_t& e) { return e.stream == stream; });
+
+    return it == entries.end() ? nullptr : &(*it);
+}
+
+void wf::workspace_stream_cache_t::touch(workspace_stream_t *stream)
+{
+    uint64_t bytes = 4ull * std::max(stream->buffer.viewport_width, 0) *
+        std::max(stream->buffer.viewport_height, 0);
+
+    auto entry = find(stream);
+    if (!entry)
+    {
+        if (bytes == 0)
+        {
+            return;
+        }
+
+        entries.push_back({stream, 0, 0});
+        entry = &entries.back();
+    }
+
+    entry->last_use = ++use_counter;
+    bool grew = bytes > entry->bytes;
+    resident_bytes = resident_bytes - entry->bytes + bytes;
+    entry->bytes   = bytes;
+
+    if (grew)
+    {
+        enforce_budget();
+    }
+}
+
+void wf::workspace_stream_cache_t::stream_stopped(workspace_stream_t *stream)
+{
+    if (find(stream))
+    {
+        enforce_budget();
+    }
+}
+
+void wf::workspace_stream_cache_t::stream_moved(workspace_stream_t *from,
+    workspace_stream_t *to)
+{
+    if (auto entry = find(from))
+    {
+        entry->stream = to;
+    }
+}
+
+void wf::workspace_stream_cache_t::forget(workspace_stream_t *stream)
+{
+    if (auto entry = find(stream))
+    {
+        resident_bytes -= entry->bytes;
+        *entry = entries.back();
+        entries.pop_back();
+    }
+}
+
+wf::workspace_stream_stats_t wf::workspace_stream_cache_t::get_stats() const
+{
+    workspace_stream_stats_t stats;
+    stats.resident_buffers = entries.size();
+    stats.resident_bytes   = resident_bytes;
+    stats.budget_bytes     = std::max(int(memory_budget), 0) * (1ull << 20);
+    stats.evictions = evictions;
+
+    return stats;
+}
+
+void wf::workspace_stream_cache_t::enforce_budget()
+{
+    uint64_t budget = std::max(int(memory_budget), 0) * (1ull << 20);
+    while (resident_bytes > budget)
+    {
+        /* Least recently used stopped stream */
+        auto victim = entries.end();
+        for (auto it = entries.begin(); it != entries.end(); ++it)
+        {
+            if (!it->stream->running &&
+                ((victim == entries.end()) || (it->last_use < victim->last_use)))
+            {
+                victim = it;
+            }
+        }
+
+        if (victim == entries.end())
+        {
+            return;
+        }
+
+        LOGD("Evicting workspace stream buffer for workspace ",
+            victim->stream->ws.x, ",", victim->stream->ws.y, ", ",
+            victim->bytes, " bytes");
+
+        OpenGL::render_begin();
+        victim->stream->buffer.release();
+        OpenGL::render_end();
+
+        ++evictions;
+        forget(victim->stream);
+    }
+}
+
+wf::workspace_stream_t::workspace_stream_t(workspace_stream_t&& other) :
+    ws(other.ws), buffer(std::move(other.buffer)), running(other.running),
+    scale_x(other.scale_x), scale_y(other.scale_y), background(other.background)
+{
+    /* Streams are only tracked once their buffer has been used */
+    if (cache_instance)
+    {
+        cache_instance->stream_moved(&other, this);
+    }
+}
+
+wf::workspace_stream_t::~workspace_stream_t()
+{
+    if (cache_instance)
+    {
+        cache_instance->forget(this);
+    }
+}
+
+wf::workspace_stream_stats_t wf::get_workspace_stream_stats()
+{
+    return workspace_stream_cache_t::get().get_stats();
+}
@@ -0,0 +1,67 @@
+#ifndef WF_OUTPUT_WORKSPACE_STREAM_CACHE_HPP
+#define WF_OUTPUT_WORKSPACE_STREAM_CACHE_HPP
+
+#include <vector>
+#include <cstdint>
+#include <wayfire/workspace-stream.hpp>
+#include <wayfire/option-wrapper.hpp>
+
+namespace wf
+{
+/**
+ * Tracks the buffers of the workspace streams on all outputs and keeps their
+ * total size within the core/workspace_stream_memory budget.
+ *
+ * When the budget is exceeded, the buffers of stopped streams are released,
+ * least recently used first. Running streams are never evicted. An evicted
+ * stream gets a new buffer and a full repaint when it is started again.
+ */
+class workspace_stream_cache_t
+{
+  public:
+    static workspace_stream_cache_t& get();
+
+    /**
+     * Mark the stream as used and update the size of its buffer. If the
+     * buffer grew, buffers of other streams may be evicted.
+     *
+     * Must not be called between OpenGL::render_begin() and render_end().
+     */
+    void touch(workspace_stream_t *stream);
+
+    /** The stream was stopped, so its buffer may now be evicted. */
+    void stream_stopped(workspace_stream_t *stream);
+
+    /** The stream moved to a different address. */
+    void stream_moved(workspace_stream_t *from, workspace_stream_t *to);
+
+    /** Stop tracking the stream, it is being destroyed. */
+    void forget(workspace_stream_t *stream);
+
+    workspace_stream_stats_t get_stats() const;
+
+  private:
+    workspace_stream_cache_t();
+
+    struct entry_t
+    {
+        workspace_stream_t *stream;
+        uint64_t bytes;
+        uint64_t last_use;
+    };
+
+    std::vector<entry_t> entries;
+    uint64_t use_counter   = 0;
+    uint64_t resident_bytes = 0;
+    uint64_t evictions     = 0;
+
+    /* In MiB */
+    wf::option_wrapper_t<int> memory_budget{"core/workspace_stream_memory"};
+
+    entry_t *find(workspace_stream_t *stream);
+    /** Evict stopped streams until the budget is met, or nothing is left */
+    void enforce_budget();
+};
+}
+
+#endif /* end of include guard: WF_OUTPUT_WORKSPACE_STREAM_CACHE_HPP */
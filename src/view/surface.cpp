@@ -399,12 +399,7 @@ void wf::wlr_surface_base_t::_simple_render(const wf::framebuffer_t& fb,
     wf::texture_t texture{surface->buffer->texture};
 
     OpenGL::render_begin(fb);
-    for (const auto& rect : damage)
-    {
-        fb.logic_scissor(wlr_box_from_pixman_box(rect));
-        OpenGL::render_texture(texture, fb, geometry);
-    }
-
+    OpenGL::render_texture(texture, fb, geometry, damage);
     OpenGL::render_end();
 }
 
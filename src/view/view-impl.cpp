@@ -14,6 +14,21 @@ extern "C"
 #include <wlr/util/edges.h>
 }
 
+/* Emitted on every move and resize, so use interned signal IDs */
+static void emit_geometry_changed(wayfire_view view,
+    wf::view_geometry_changed_signal *data)
+{
+    static const wf::signal_id_t geometry_changed{"geometry-changed"};
+    static const wf::signal_id_t view_geometry_changed{"view-geometry-changed"};
+
+    view->emit_signal(geometry_changed, data);
+    wf::get_core().emit_signal(view_geometry_changed, data);
+    if (view->get_output())
+    {
+        view->get_output()->emit_signal(view_geometry_changed, data);
+    }
+}
+
 wf::wlr_view_t::wlr_view_t() :
     wf::wlr_surface_base_t(this), wf::view_interface_t()
 {}
@@ -135,12 +150,7 @@ void wf::wlr_view_t::set_position(int x, int y,
 
     if (send_signal)
     {
-        emit_signal("geometry-changed", &data);
-        wf::get_core().emit_signal("view-geometry-changed", &data);
-        if (get_output())
-        {
-            get_output()->emit_signal("view-geometry-changed", &data);
-        }
+        emit_geometry_changed(self(), &data);
     }
 
     last_bounding_box = get_bounding_box();
@@ -199,12 +209,7 @@ void wf::wlr_view_t::update_size()
     /* Damage new size */
     last_bounding_box = get_bounding_box();
     view_damage_raw(self(), last_bounding_box);
-    emit_signal("geometry-changed", &data);
-    wf::get_core().emit_signal("view-geometry-changed", &data);
-    if (get_output())
-    {
-        get_output()->emit_signal("view-geometry-changed", &data);
-    }
+    emit_geometry_changed(self(), &data);
 
     if (view_impl->frame)
     {
@@ -85,6 +85,13 @@ class view_interface_t::view_priv_impl
  */
 void view_damage_raw(wayfire_view view, const wlr_box& box);
 
+/**
+ * Same as view_damage_raw(view, box), but additionally reports which part of
+ * the untransformed view is damaged to the view's region-damaged listeners.
+ */
+void view_damage_raw(wayfire_view view, const wlr_box& box,
+    const wlr_box& untransformed_box);
+
 /**
  * Implementation of a view backed by a wlr_* shell struct.
  */
@@ -222,6 +229,11 @@ void init_layer_shell();
 
 void xwayland_set_seat(wlr_seat *seat);
 std::string xwayland_get_display();
+/**
+ * @return The number of configures to Xwayland views which were dropped
+ *   because a newer configure was queued for the same view before it was sent.
+ */
+uint64_t xwayland_get_suppressed_configures();
 void xwayland_set_cursor(wlr_xcursor_image *image);
 
 void init_desktop_apis();
@@ -10,10 +10,12 @@
 #include "wayfire/render-manager.hpp"
 #include "xdg-shell.hpp"
 #include "../output/gtk-shell.hpp"
+#include "../output/output-impl.hpp"
 
 #include <algorithm>
 #include <glm/glm.hpp>
 #include "wayfire/signal-definitions.hpp"
+#include <wayfire/nonstd/reverse.hpp>
 
 extern "C"
 {
@@ -174,6 +176,25 @@ std::vector<wayfire_view> wf::view_interface_t::enumerate_views(
     return result;
 }
 
+bool wf::view_interface_t::for_each_view(view_visitor_t visitor,
+    bool mapped_only)
+{
+    if (!this->is_mapped() && mapped_only)
+    {
+        return false;
+    }
+
+    for (auto& v : this->children)
+    {
+        if (v->for_each_view(visitor, mapped_only))
+        {
+            return true;
+        }
+    }
+
+    return visitor(self());
+}
+
 void wf::view_interface_t::set_role(view_role_t new_role)
 {
     role = new_role;
@@ -648,7 +669,7 @@ void wf::view_interface_t::damage()
 {
     auto bbox = get_untransformed_bounding_box();
     view_impl->offscreen_buffer.cached_damage |= bbox;
-    view_damage_raw(self(), transform_region(bbox));
+    view_damage_raw(self(), transform_region(bbox), bbox);
 }
 
 wlr_box wf::view_interface_t::get_minimize_hint()
@@ -772,6 +793,10 @@ void wf::view_interface_t::add_transformer(
     });
 
     damage();
+    if (get_output())
+    {
+        ((wf::output_impl_t*)get_output())->input_index->invalidate();
+    }
 }
 
 nonstd::observer_ptr<wf::view_transformer_t> wf::view_interface_t::get_transformer(
@@ -804,6 +829,7 @@ void wf::view_interface_t::pop_transformer(
     if (get_output())
     {
         get_output()->render->damage_whole_idle();
+        ((wf::output_impl_t*)get_output())->input_index->invalidate();
     }
 }
 
@@ -817,6 +843,11 @@ bool wf::view_interface_t::has_transformer()
     return view_impl->transforms.size();
 }
 
+size_t wf::view_interface_t::get_transformer_count()
+{
+    return view_impl->transforms.size();
+}
+
 wf::geometry_t wf::view_interface_t::get_untransformed_bounding_box()
 {
     if (!is_mapped())
@@ -1033,20 +1064,7 @@ bool wf::view_interface_t::render_transformed(const wf::framebuffer_t& framebuff
     if (final_transform == nullptr)
     {
         OpenGL::render_begin(framebuffer);
-        auto matrix = framebuffer.get_orthographic_projection();
-        gl_geometry src_geometry = {
-            1.0f * obox.x, 1.0f * obox.y,
-            1.0f * obox.x + 1.0f * obox.width,
-            1.0f * obox.y + 1.0f * obox.height,
-        };
-
-        for (const auto& rect : damage)
-        {
-            framebuffer.logic_scissor(wlr_box_from_pixman_box(rect));
-            OpenGL::render_transformed_texture(previous_texture, src_geometry,
-                {}, matrix);
-        }
-
+        OpenGL::render_texture(previous_texture, framebuffer, obox, damage);
         OpenGL::render_end();
     } else
     {
@@ -1184,10 +1202,16 @@ void wf::view_interface_t::damage_surface_box(const wlr_box& box)
     damaged.x += obox.x;
     damaged.y += obox.y;
     view_impl->offscreen_buffer.cached_damage |= damaged;
-    view_damage_raw(self(), transform_region(damaged));
+    view_damage_raw(self(), transform_region(damaged), damaged);
 }
 
 void wf::view_damage_raw(wayfire_view view, const wlr_box& box)
+{
+    view_damage_raw(view, box, view->get_untransformed_bounding_box());
+}
+
+void wf::view_damage_raw(wayfire_view view, const wlr_box& box,
+    const wlr_box& untransformed_box)
 {
     auto output = view->get_output();
     if (!output)
@@ -1220,7 +1244,18 @@ void wf::view_damage_raw(wayfire_view view, const wlr_box& box)
         output->render->damage(box);
     }
 
-    view->emit_signal("region-damaged", nullptr);
+    /* Emitted on every damage, so avoid looking up the name each time */
+    static const wf::signal_id_t region_damaged{"region-damaged"};
+    wf::view_damaged_signal damaged;
+    damaged.view = view;
+    damaged.box  = untransformed_box;
+    view->emit_signal(region_damaged, &damaged);
+
+    static const wf::signal_id_t view_region_damaged{"view-region-damaged"};
+    wf::view_region_damaged_signal data;
+    data.view = view;
+    data.box  = box;
+    output->emit_signal(view_region_damaged, &data);
 }
 
 void wf::view_interface_t::destruct()
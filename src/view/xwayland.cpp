@@ -30,6 +30,10 @@ class wayfire_xwayland_view_base : public wf::wlr_view_t
   protected:
     static xcb_atom_t _NET_WM_WINDOW_TYPE_NORMAL;
 
+    /** Number of configures which were replaced by a later one before they
+     * were sent, over all xwayland views */
+    static uint64_t suppressed_configures;
+
   public:
     static bool load_atoms()
     {
@@ -78,11 +82,54 @@ class wayfire_xwayland_view_base : public wf::wlr_view_t
         }
     };
 
+    /**
+     * Configures of mapped views are not sent right away, because views may
+     * be moved many times in a row (for ex. when switching workspaces).
+     * Instead, the last configure is sent once the event loop goes idle.
+     * This does not depend on the output repainting, so configures are not
+     * held back while the output is disabled, off or inhibited.
+     */
+    wf::wl_idle_call idle_configure;
+    wf::geometry_t pending_configure;
+
+    void flush_configure()
+    {
+        if (xw)
+        {
+            wlr_xwayland_surface_configure(xw, pending_configure.x,
+                pending_configure.y, pending_configure.width,
+                pending_configure.height);
+        }
+    }
+
+    void queue_configure(wf::geometry_t configure)
+    {
+        if (idle_configure.is_connected())
+        {
+            ++suppressed_configures;
+        } else
+        {
+            idle_configure.run_once([=] () { flush_configure(); });
+        }
+
+        pending_configure = configure;
+    }
+
+    void cancel_pending_configure()
+    {
+        idle_configure.disconnect();
+    }
+
   public:
     wayfire_xwayland_view_base(wlr_xwayland_surface *xww) :
         wlr_view_t(), xw(xww)
     {}
 
+    static uint64_t get_suppressed_configures()
+    {
+        return suppressed_configures;
+    }
+
     virtual void initialize() override
     {
         wf::wlr_view_t::initialize();
@@ -179,6 +226,7 @@ class wayfire_xwayland_view_base : public wf::wlr_view_t
 
     virtual void destroy() override
     {
+        cancel_pending_configure();
         this->xw = nullptr;
         output_geometry_changed.disconnect();
 
@@ -267,8 +315,15 @@ class wayfire_xwayland_view_base : public wf::wlr_view_t
             configure_y += real_output.y;
         }
 
-        wlr_xwayland_surface_configure(xw,
-            configure_x, configure_y, width, height);
+        if (is_mapped() && get_output())
+        {
+            queue_configure({configure_x, configure_y, width, height});
+        } else
+        {
+            cancel_pending_configure();
+            wlr_xwayland_surface_configure(xw,
+                configure_x, configure_y, width, height);
+        }
     }
 
     void send_configure()
@@ -305,6 +360,7 @@ class wayfire_xwayland_view_base : public wf::wlr_view_t
 };
 
 xcb_atom_t wayfire_xwayland_view_base::_NET_WM_WINDOW_TYPE_NORMAL;
+uint64_t wayfire_xwayland_view_base::suppressed_configures = 0;
 
 class wayfire_unmanaged_xwayland_view : public wayfire_xwayland_view_base
 {
@@ -755,6 +811,8 @@ void wf::init_xwayland()
 
     static signal_connection_t on_shutdown{[&] (void*)
         {
+            LOGD("Suppressed ", xwayland_get_suppressed_configures(),
+                " coalesced Xwayland configures");
             wlr_xwayland_destroy(xwayland_handle);
         }
     };
@@ -833,3 +891,14 @@ std::string wf::xwayland_get_display()
     return "";
 #endif
 }
+
+uint64_t wf::xwayland_get_suppressed_configures()
+{
+#if WF_HAS_XWAYLAND
+
+    return wayfire_xwayland_view_base::get_suppressed_configures();
+#else
+
+    return 0;
+#endif
+}
@@ -0,0 +1,137 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include "../src/output/animation-drivers.hpp"
+
+/**
+ * A minimal model of the output's frame loop: a frame is painted if the
+ * output was damaged or the drivers need it, and the next frame is scheduled
+ * only when the drivers ask for it.
+ */
+struct frame_loop_t
+{
+    wf::animation_driver_list_t drivers;
+    bool frame_scheduled = false;
+    bool damaged = false;
+    int painted  = 0;
+
+    /* Run the frame loop until the output goes idle, at most max frames */
+    void run(int max = 1000)
+    {
+        for (int i = 0; (i < max) && frame_scheduled; i++)
+        {
+            frame_scheduled = false;
+            drivers.run();
+            if (damaged || drivers.needs_frame())
+            {
+                ++painted;
+            }
+
+            damaged = false;
+            frame_scheduled |= drivers.needs_next_frame();
+        }
+    }
+};
+
+TEST_CASE("an animation causes one frame per step and one final frame")
+{
+    frame_loop_t loop;
+    int steps = 0;
+    wf::animation_driver_list_t::driver_t driver = [&] ()
+    {
+        return ++steps < 10;
+    };
+
+    loop.drivers.add(&driver);
+    loop.frame_scheduled = true;
+    loop.run();
+
+    /* 9 frames with progress, the 10th shows the final state */
+    REQUIRE(steps == 10);
+    REQUIRE(loop.painted == 10);
+    REQUIRE_FALSE(loop.frame_scheduled);
+
+    SUBCASE("an idle driver does not cause frames")
+    {
+        loop.frame_scheduled = true;
+        loop.run();
+        REQUIRE(loop.painted == 10);
+
+        loop.frame_scheduled = true;
+        loop.damaged = true;
+        loop.run();
+        REQUIRE(loop.painted == 11);
+        REQUIRE_FALSE(loop.frame_scheduled);
+    }
+
+    SUBCASE("restarting the animation wakes the output up")
+    {
+        steps = 5;
+        loop.frame_scheduled = true;
+        loop.run();
+        REQUIRE(loop.painted == 10 + 5);
+    }
+}
+
+TEST_CASE("overlapping animations keep the output busy until the last ends")
+{
+    frame_loop_t loop;
+    int short_steps = 0, long_steps = 0;
+    wf::animation_driver_list_t::driver_t short_driver = [&] ()
+    {
+        return ++short_steps < 3;
+    };
+    wf::animation_driver_list_t::driver_t long_driver = [&] ()
+    {
+        return ++long_steps < 8;
+    };
+
+    loop.drivers.add(&short_driver);
+    loop.drivers.add(&long_driver);
+    loop.frame_scheduled = true;
+    loop.run();
+
+    REQUIRE(long_steps == 8);
+    REQUIRE(loop.painted == 8);
+}
+
+TEST_CASE("removed drivers stop causing frames")
+{
+    frame_loop_t loop;
+    int steps = 0;
+    wf::animation_driver_list_t::driver_t driver = [&] ()
+    {
+        ++steps;
+        return true;
+    };
+
+    loop.drivers.add(&driver);
+    loop.frame_scheduled = true;
+    loop.run(5);
+    REQUIRE(loop.painted == 5);
+    REQUIRE(loop.frame_scheduled);
+
+    loop.drivers.remove(&driver);
+    loop.run();
+
+    /* One more frame for the final state, then idle */
+    REQUIRE(steps == 5);
+    REQUIRE(loop.painted == 6);
+    REQUIRE_FALSE(loop.frame_scheduled);
+}
+
+TEST_CASE("drivers may remove themselves while running")
+{
+    frame_loop_t loop;
+    wf::animation_driver_list_t::driver_t driver;
+    driver = [&] ()
+    {
+        loop.drivers.remove(&driver);
+        return false;
+    };
+
+    loop.drivers.add(&driver);
+    loop.frame_scheduled = true;
+    loop.run();
+    REQUIRE(loop.painted == 0);
+}
@@ -0,0 +1,184 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/nonstd/safe-list.hpp>
+#include <memory>
+#include <vector>
+
+static std::vector<int> contents(const wf::safe_list_t<int>& list)
+{
+    std::vector<int> result;
+    list.for_each([&] (int x) { result.push_back(x); });
+    return result;
+}
+
+TEST_CASE("safe_list_t basic operations")
+{
+    wf::safe_list_t<int> list;
+    list.push_back(1);
+    list.push_back(2);
+    list.push_back(3);
+    REQUIRE(list.size() == 3);
+    REQUIRE(list.back() == 3);
+
+    list.remove_all(2);
+    REQUIRE(contents(list) == std::vector<int>{1, 3});
+
+    list.insert_at(2, [] (int x)
+    {
+        return x == 3 ? wf::safe_list_t<int>::INSERT_BEFORE :
+               wf::safe_list_t<int>::INSERT_NONE;
+    });
+    REQUIRE(contents(list) == std::vector<int>{1, 2, 3});
+
+    list.clear();
+    REQUIRE(list.size() == 0);
+    REQUIRE_THROWS(list.back());
+}
+
+TEST_CASE("safe_list_t mutation during for_each")
+{
+    wf::safe_list_t<int> list;
+    for (int i = 1; i <= 4; i++)
+    {
+        list.push_back(i);
+    }
+
+    SUBCASE("push_back is deferred until the iteration ends")
+    {
+        std::vector<int> visited;
+        list.for_each([&] (int x)
+        {
+            visited.push_back(x);
+            list.push_back(x * 10);
+        });
+
+        REQUIRE(visited == std::vector<int>{1, 2, 3, 4});
+        REQUIRE(contents(list) == std::vector<int>{1, 2, 3, 4, 10, 20, 30, 40});
+    }
+
+    SUBCASE("removed elements are not visited")
+    {
+        std::vector<int> visited;
+        list.for_each([&] (int x)
+        {
+            visited.push_back(x);
+            if (x == 1)
+            {
+                list.remove_all(3);
+            }
+        });
+
+        REQUIRE(visited == std::vector<int>{1, 2, 4});
+        REQUIRE(list.size() == 3);
+        REQUIRE(contents(list) == std::vector<int>{1, 2, 4});
+    }
+
+    SUBCASE("removing the current element")
+    {
+        list.for_each([&] (int x) { list.remove_all(x); });
+        REQUIRE(list.size() == 0);
+        REQUIRE(contents(list).empty());
+    }
+
+    SUBCASE("insert keeps the order of pending elements")
+    {
+        list.for_each([&] (int x)
+        {
+            if (x == 2)
+            {
+                auto before_three = [] (int y)
+                {
+                    return y == 3 ? wf::safe_list_t<int>::INSERT_BEFORE :
+                           wf::safe_list_t<int>::INSERT_NONE;
+                };
+
+                list.insert_at(5, before_three);
+                list.insert_at(6, before_three);
+                REQUIRE(list.size() == 6);
+                REQUIRE(list.back() == 4);
+            }
+        });
+
+        REQUIRE(contents(list) == std::vector<int>{1, 2, 5, 6, 3, 4});
+    }
+
+    SUBCASE("pending elements can be removed before they are merged")
+    {
+        list.for_each([&] (int x)
+        {
+            if (x == 1)
+            {
+                list.push_back(7);
+                REQUIRE(list.back() == 7);
+                list.remove_all(7);
+                REQUIRE(list.back() == 4);
+            }
+        });
+
+        REQUIRE(contents(list) == std::vector<int>{1, 2, 3, 4});
+    }
+}
+
+TEST_CASE("safe_list_t nested for_each defers compaction")
+{
+    wf::safe_list_t<int> list;
+    for (int i = 1; i <= 3; i++)
+    {
+        list.push_back(i);
+    }
+
+    std::vector<std::pair<int, int>> visited;
+    list.for_each([&] (int outer)
+    {
+        list.for_each([&] (int inner)
+        {
+            visited.push_back({outer, inner});
+            if ((outer == 1) && (inner == 1))
+            {
+                list.remove_all(2);
+                list.push_back(4);
+            }
+        });
+
+        /* The inner iteration ended, but the outer one still runs, so the
+         * removed and added elements are not merged yet */
+        REQUIRE(list.size() == 3);
+    });
+
+    REQUIRE(visited == std::vector<std::pair<int, int>>{
+        {1, 1}, {1, 3}, {3, 1}, {3, 3}});
+    REQUIRE(contents(list) == std::vector<int>{1, 3, 4});
+}
+
+TEST_CASE("safe_list_t element destructors may use the list")
+{
+    struct element_t
+    {
+        wf::safe_list_t<std::shared_ptr<element_t>> *list;
+        int *visited;
+
+        element_t(wf::safe_list_t<std::shared_ptr<element_t>> *list,
+            int *visited) : list(list), visited(visited)
+        {}
+
+        ~element_t()
+        {
+            /* The slot of the destroyed element is already empty */
+            list->for_each([&] (const std::shared_ptr<element_t>& e)
+            {
+                REQUIRE(e.get() != this);
+                ++*visited;
+            });
+        }
+    };
+
+    wf::safe_list_t<std::shared_ptr<element_t>> list;
+    int visited = 0;
+    list.push_back(std::make_shared<element_t>(&list, &visited));
+    list.push_back(std::make_shared<element_t>(&list, &visited));
+
+    list.clear();
+    REQUIRE(visited == 1);
+    REQUIRE(list.size() == 0);
+}
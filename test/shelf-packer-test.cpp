@@ -0,0 +1,93 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/plugins/common/shelf-packer.hpp>
+#include <random>
+#include <vector>
+
+struct rect_t
+{
+    int x, y, width, height;
+};
+
+static bool overlap(const rect_t& a, const rect_t& b)
+{
+    return a.x < b.x + b.width && b.x < a.x + a.width &&
+           a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+TEST_CASE("rectangles are packed in shelves")
+{
+    wf::shelf_packer_t packer{100, 100};
+    int x, y;
+
+    REQUIRE(packer.pack(40, 10, x, y));
+    REQUIRE((x == 0 && y == 0));
+    REQUIRE(packer.pack(40, 20, x, y));
+    REQUIRE((x == 40 && y == 0));
+
+    /* Does not fit in the rest of the first shelf, which is 20 high */
+    REQUIRE(packer.pack(30, 5, x, y));
+    REQUIRE((x == 0 && y == 20));
+    REQUIRE(packer.pack(70, 5, x, y));
+    REQUIRE((x == 30 && y == 20));
+}
+
+TEST_CASE("full packer rejects rectangles")
+{
+    wf::shelf_packer_t packer{100, 100};
+    int x, y;
+
+    REQUIRE_FALSE(packer.pack(101, 1, x, y));
+    REQUIRE_FALSE(packer.pack(1, 101, x, y));
+
+    for (int i = 0; i < 10; i++)
+    {
+        REQUIRE(packer.pack(100, 10, x, y));
+        REQUIRE(y == 10 * i);
+    }
+
+    REQUIRE_FALSE(packer.pack(1, 1, x, y));
+
+    SUBCASE("reset starts from the top-left corner")
+    {
+        packer.reset();
+        REQUIRE(packer.pack(50, 50, x, y));
+        REQUIRE((x == 0 && y == 0));
+    }
+}
+
+TEST_CASE("packed rectangles are inside the area and do not overlap")
+{
+    const int size = 256;
+    wf::shelf_packer_t packer{size, size};
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dim(1, 24);
+
+    std::vector<rect_t> packed;
+    int failures = 0;
+    for (int i = 0; i < 1000; i++)
+    {
+        rect_t r{0, 0, dim(rng), dim(rng)};
+        if (!packer.pack(r.width, r.height, r.x, r.y))
+        {
+            ++failures;
+            continue;
+        }
+
+        REQUIRE(r.x >= 0);
+        REQUIRE(r.y >= 0);
+        REQUIRE(r.x + r.width <= size);
+        REQUIRE(r.y + r.height <= size);
+        for (auto& other : packed)
+        {
+            REQUIRE_FALSE(overlap(r, other));
+        }
+
+        packed.push_back(r);
+    }
+
+    /* The area is too small for all of them */
+    REQUIRE(failures > 0);
+    REQUIRE(packed.size() > 100);
+}
@@ -0,0 +1,96 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/task-pool.hpp>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+TEST_CASE("parallel_for processes every item exactly once")
+{
+    auto& pool = wf::get_task_pool();
+    REQUIRE(pool.get_concurrency() >= 1);
+
+    for (int count : {1, 7, 64, 1000, 100003})
+    {
+        std::vector<std::atomic<int>> visits(count);
+        pool.parallel_for(count, 16, [&] (int start, int end)
+        {
+            REQUIRE(start < end);
+            for (int i = start; i < end; i++)
+            {
+                visits[i].fetch_add(1);
+            }
+        });
+
+        for (int i = 0; i < count; i++)
+        {
+            REQUIRE(visits[i].load() == 1);
+        }
+    }
+}
+
+TEST_CASE("parallel_for respects the minimal chunk size")
+{
+    auto& pool = wf::get_task_pool();
+
+    std::mutex mutex;
+    std::vector<std::pair<int, int>> chunks;
+    pool.parallel_for(1000, 100, [&] (int start, int end)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        chunks.push_back({start, end});
+    });
+
+    int total = 0;
+    for (auto& chunk : chunks)
+    {
+        total += chunk.second - chunk.first;
+        if (chunk.second != 1000)
+        {
+            REQUIRE(chunk.second - chunk.first >= 100);
+        }
+    }
+
+    REQUIRE(total == 1000);
+}
+
+TEST_CASE("small workloads run inline")
+{
+    auto& pool = wf::get_task_pool();
+    auto caller = std::this_thread::get_id();
+
+    int calls = 0;
+    pool.parallel_for(10, 16, [&] (int start, int end)
+    {
+        REQUIRE(std::this_thread::get_id() == caller);
+        REQUIRE(start == 0);
+        REQUIRE(end == 10);
+        ++calls;
+    });
+    REQUIRE(calls == 1);
+
+    pool.parallel_for(0, 1, [&] (int, int) { ++calls; });
+    REQUIRE(calls == 1);
+}
+
+TEST_CASE("parallel_for can be called repeatedly")
+{
+    auto& pool = wf::get_task_pool();
+
+    /* Workers which wake up late must not run an older job again */
+    std::atomic<int64_t> sum{0};
+    for (int round = 0; round < 500; round++)
+    {
+        pool.parallel_for(256, 1, [&] (int start, int end)
+        {
+            for (int i = start; i < end; i++)
+            {
+                sum.fetch_add(i);
+            }
+        });
+    }
+
+    REQUIRE(sum.load() == 500LL * (255 * 256 / 2));
+}